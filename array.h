@@ -0,0 +1,311 @@
+#ifndef ARRAY_H
+#define ARRAY_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+#include "iosched.h"
+
+// How logical tracks are spread over the devices of an array. Negative
+// tracks, which single-device runs accept too, are placed by rounding down.
+//   stripe[:width]    stripe units of `width` consecutive tracks, round-robin
+//   range:<maxtracks> each device holds one contiguous slice of [0, maxtracks);
+//                     tracks below go to the first device, above to the last
+//   hash              tracks scattered by a hash; no locality is preserved
+struct PlacementPolicy {
+    enum Kind { Stripe, Range, Hash };
+    Kind kind = Stripe;
+    int width = 1;
+    int maxtracks = 0;
+
+    // Division and remainder by b > 0 rounding towards negative infinity, so
+    // every device number comes out in [0, devices)
+    static int floorDiv(int a, int b) { return a / b - (a % b < 0); }
+    static int floorMod(int a, int b) { int r = a % b; return r < 0 ? r + b : r; }
+
+    // Device holding a logical track, and the track's position on that device
+    std::pair<int, int> place(int track, int devices) const {
+        switch (kind) {
+            case Range: {
+                int perDevice = std::max(1, (maxtracks + devices - 1) / devices);
+                int device = std::clamp(floorDiv(track, perDevice), 0, devices - 1);
+                return {device, track - device * perDevice};
+            }
+            case Hash: {
+                uint64_t h = static_cast<uint64_t>(track) * 0x9E3779B97F4A7C15ULL;
+                h ^= h >> 32;
+                return {static_cast<int>(h % devices), track};
+            }
+            default: {
+                int unit = floorDiv(track, width);
+                return {floorMod(unit, devices), floorDiv(unit, devices) * width + floorMod(track, width)};
+            }
+        }
+    }
+};
+
+inline bool parsePlacementPolicy(const std::string& text, PlacementPolicy& policy) {
+    std::string name = text.substr(0, text.find(':'));
+    std::string arg = text.find(':') == std::string::npos ? "" : text.substr(text.find(':') + 1);
+    std::istringstream value(arg);
+    if (name == "stripe") {
+        policy.kind = PlacementPolicy::Stripe;
+        if (!arg.empty() && !(value >> policy.width)) policy.width = 0;
+        if (policy.width < 1) {
+            std::cerr << "Invalid stripe width: " << arg << "\n";
+            return false;
+        }
+    } else if (name == "range") {
+        policy.kind = PlacementPolicy::Range;
+        if (!(value >> policy.maxtracks) || policy.maxtracks < 1) {
+            std::cerr << "Range placement needs the track count, e.g. range:10000\n";
+            return false;
+        }
+    } else if (name == "hash") {
+        policy.kind = PlacementPolicy::Hash;
+    } else {
+        std::cerr << "Unknown placement policy: " << text << "\n";
+        return false;
+    }
+    return true;
+}
+
+// An array of independent devices, each with its own head and its own
+// scheduler instance. Arrivals are routed to a device by the placement
+// policy; all devices share one clock and are stepped from event to event
+// together.
+class DiskArray {
+private:
+    std::vector<std::unique_ptr<Simulator>> devices;
+    std::shared_ptr<RequestPool> pool = std::make_shared<RequestPool>(); // Shared by all devices
+    PlacementPolicy policy;
+    std::vector<IORequest> arrivals;             // Arrivals admitted together by run()
+    std::vector<std::vector<IORequest>> batches; // The same, split by device
+    int64_t clock = 0;                           // Shared by all devices
+    long long admitted = 0;                      // Requests run() has taken from the trace
+    std::function<void()> checkpoint;            // See Simulator::checkpointEvery
+    int checkpointInterval = 0;
+    profile::Counters profiled;                  // Filled by run() in profiling builds
+
+    DiskArray() = default;
+
+public:
+    // Create an array of `count` devices, or nullptr when Simulator::create
+    // would reject the algorithm or tuning
+    static std::unique_ptr<DiskArray> create(char schedulerType, int count, const PlacementPolicy& placement,
+                                             const CostModel& cost = CostModel(),
+                                             const SchedulerTuning& tuning = SchedulerTuning()) {
+        std::unique_ptr<DiskArray> array(new DiskArray());
+        array->policy = placement;
+        for (int i = 0; i < count; i++) {
+            array->devices.push_back(Simulator::create(schedulerType, cost, tuning, array->pool));
+            if (!array->devices.back()) {
+                return nullptr;
+            }
+        }
+        return array;
+    }
+
+    size_t deviceCount() const { return devices.size(); }
+    const Simulator& device(size_t i) const { return *devices[i]; }
+
+    // Route a request to its device, translated to the device's own tracks.
+    // Returns false if the device dropped it; see Simulator::addRequest.
+    bool addRequest(IORequest req) {
+        auto [device, localTrack] = policy.place(req.track, static_cast<int>(devices.size()));
+        req.track = localTrack;
+        return devices[device]->addRequest(req);
+    }
+
+    // Route a batch of arrivals, in arrival order. Each device gets its
+    // share as one batch.
+    bool addRequests(std::span<const IORequest> reqs) {
+        bool added = true;
+        batches.resize(devices.size());
+        for (const auto& req : reqs) {
+            auto [device, localTrack] = policy.place(req.track, static_cast<int>(devices.size()));
+            batches[device].push_back(req);
+            batches[device].back().track = localTrack;
+        }
+        for (size_t i = 0; i < devices.size(); i++) {
+            if (batches[i].empty()) continue;
+            added = devices[i]->addRequests(batches[i]) && added;
+            batches[i].clear();
+        }
+        return added;
+    }
+
+    // Stream the completions of every device; see Simulator::streamCompletions
+    void streamCompletions(const std::function<void(const IORequest&)>& sink) {
+        for (auto& dev : devices) {
+            dev->streamCompletions(sink);
+        }
+    }
+
+    long long completedCount() const {
+        long long total = 0;
+        for (const auto& dev : devices) {
+            total += dev->completedCount();
+        }
+        return total;
+    }
+
+    bool hasRequests() const {
+        for (const auto& dev : devices) {
+            if (dev->hasRequests()) return true;
+        }
+        return false;
+    }
+
+    // Run the trace to completion. Same loop as Simulator::run, except that
+    // every device is brought up to the shared clock at each event and the
+    // next event is the earliest one over all devices.
+    void run(TraceSource& trace) {
+        PROFILE_RUN(profiled);
+        IORequest nextArrival;
+        bool hasArrival = trace.next(nextArrival);
+        long long nextCheckpoint = 0;
+        if (checkpointInterval > 0) {
+            nextCheckpoint = (clock / checkpointInterval + 1) * static_cast<long long>(checkpointInterval);
+        }
+
+        while (true) {
+            if (checkpointInterval > 0 && clock >= nextCheckpoint) {
+                checkpoint();
+                nextCheckpoint = (clock / checkpointInterval + 1) * static_cast<long long>(checkpointInterval);
+            }
+
+            // Admit every arrival due by now in one batch
+            if (hasArrival && nextArrival.arrivalTime <= clock) {
+                PROFILE_PHASE(Admission);
+                arrivals.clear();
+                do {
+                    arrivals.push_back(nextArrival);
+                    hasArrival = trace.next(nextArrival);
+                } while (hasArrival && nextArrival.arrivalTime <= clock);
+                addRequests(arrivals);
+                admitted += arrivals.size();
+            }
+
+            for (auto& dev : devices) {
+                dev->advanceTo(clock);
+                dev->processCurrentTime();
+            }
+
+            // Check if all requests are processed
+            if (!hasRequests() && !hasArrival) {
+                break;
+            }
+
+            int64_t nextEventTime = hasArrival ? nextArrival.arrivalTime : INT64_MAX;
+            for (const auto& dev : devices) {
+                nextEventTime = std::min(nextEventTime, dev->completionTime());
+            }
+            clock = std::max(nextEventTime, clock);
+        }
+    }
+
+    void checkpointEvery(int interval, std::function<void()> hook) {
+        checkpointInterval = interval;
+        checkpoint = std::move(hook);
+    }
+
+    long long admittedCount() const { return admitted; }
+
+    // See Simulator::profileCounters
+    const profile::Counters& profileCounters() const { return profiled; }
+
+    // Checkpointing: the shared pool once, then every device
+    void save(SnapshotWriter& out) const {
+        pool->save(out);
+        out.put(clock);
+        out.put(admitted);
+        out.put<uint64_t>(devices.size());
+        for (const auto& dev : devices) {
+            dev->save(out, false);
+        }
+    }
+
+    bool restore(SnapshotReader& in) {
+        pool->restore(in);
+        in.get(clock);
+        in.get(admitted);
+        if (in.get<uint64_t>() != devices.size()) {
+            return false;
+        }
+        for (auto& dev : devices) {
+            if (!dev->restore(in, false)) return false;
+        }
+        return in.ok();
+    }
+
+
+    // Aggregate figures over all devices. io_utilization is the mean over
+    // the devices, so it stays in [0, 1] regardless of the device count.
+    Statistics statistics() const {
+        int64_t totalMovement = 0;
+        int64_t busyTime = 0;
+        RunningStats totals;
+        for (const auto& dev : devices) {
+            totalMovement += dev->state().totalMovement;
+            busyTime += dev->state().busyTime;
+            totals.merge(dev->runningStats());
+        }
+        Statistics stats = totals.summarize(totalMovement, busyTime);
+        stats.io_utilization /= devices.size();
+        return stats;
+    }
+
+    long long merges() const {
+        long long total = 0;
+        for (const auto& dev : devices) {
+            total += dev->merges();
+        }
+        return total;
+    }
+
+    QueueWaits queueWaits() const {
+        QueueWaits all;
+        for (const auto& dev : devices) {
+            all.merge(dev->queueWaits());
+        }
+        return all;
+    }
+
+    AnticipationStats anticipation() const {
+        AnticipationStats all;
+        for (const auto& dev : devices) {
+            all.merge(dev->anticipation());
+        }
+        return all;
+    }
+
+    LatencyHistograms latencyHistograms() const {
+        LatencyHistograms all;
+        for (const auto& dev : devices) {
+            all.merge(dev->latencyHistograms());
+        }
+        return all;
+    }
+
+    // Per-request lines, then one DEV<i> SUM: line per device, then the
+    // aggregate SUM: line
+    void printStatistics() const {
+        printCompletedRequests(*pool);
+        for (size_t i = 0; i < devices.size(); i++) {
+            std::cout << "DEV" << i << " " << devices[i]->completedCount() << " ";
+            printSummary(std::cout, devices[i]->statistics());
+        }
+        if (completedCount() > 0) {
+            printSummary(std::cout, statistics());
+        }
+    }
+};
+
+#endif // ARRAY_H
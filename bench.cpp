@@ -0,0 +1,353 @@
+// Microbenchmarks for the scheduler hot paths and end-to-end throughput.
+//
+//   make bench
+//   ./iosched_bench [--filter=<substring>] [--min-time=<seconds>]
+//                   [--max-depth=<n>] [--format=console|csv|json]
+//
+// Benchmark names are <operation>/<algorithm>/<distribution>/<depth>. The
+// JSON output follows the layout of Google Benchmark's --benchmark_format=json
+// so existing regression tooling can read it.
+
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <cstdlib>
+
+#include "iosched.h"
+#include "trace.h"
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int benchMaxTracks = 1000000;
+constexpr int traceMaxTracks = 10000; // Keeps end-to-end clocks well inside int range
+
+// Timing control handed to a benchmark body, in the spirit of
+// benchmark::State: the body performs `iterations` operations and may pause
+// the clock around setup work that should not be measured
+class BenchState {
+private:
+    Clock::time_point started;
+    Clock::duration total{};
+
+public:
+    size_t iterations;
+
+    explicit BenchState(size_t iters) : iterations(iters) {}
+
+    void resumeTiming() {
+        started = Clock::now();
+    }
+
+    void pauseTiming() {
+        total += Clock::now() - started;
+    }
+
+    double seconds() const {
+        return std::chrono::duration<double>(total).count();
+    }
+};
+
+struct Benchmark {
+    std::string name;
+    size_t itemsPerIteration;
+    std::function<void(BenchState&)> body;
+    size_t initialIterations = 1; // Skips probe runs that would be dominated by queue setup
+};
+
+struct BenchResult {
+    std::string name;
+    size_t iterations;
+    double seconds;
+    double nsPerItem;
+    double itemsPerSecond;
+};
+
+// Track distributions used to fill the queues
+enum class Distribution { Uniform, Hotspot, Sequential };
+
+const char* distributionName(Distribution dist) {
+    switch (dist) {
+        case Distribution::Uniform: return "uniform";
+        case Distribution::Hotspot: return "hotspot";
+        default: return "sequential";
+    }
+}
+
+// Generate n tracks: uniform over the disk, 90% of accesses on 10% of the
+// tracks, or runs of 64 consecutive tracks starting at random positions
+std::vector<int> makeTracks(Distribution dist, size_t n, std::mt19937& rng, int maxTracks = benchMaxTracks) {
+    std::uniform_int_distribution<int> anyTrack(0, maxTracks - 1);
+    std::uniform_int_distribution<int> hotTrack(0, maxTracks / 10 - 1);
+    std::uniform_real_distribution<double> coin(0.0, 1.0);
+    std::vector<int> tracks(n);
+    int runStart = 0;
+    for (size_t i = 0; i < n; i++) {
+        switch (dist) {
+            case Distribution::Uniform:
+                tracks[i] = anyTrack(rng);
+                break;
+            case Distribution::Hotspot:
+                tracks[i] = coin(rng) < 0.9 ? hotTrack(rng) : anyTrack(rng);
+                break;
+            case Distribution::Sequential:
+                if (i % 64 == 0) runStart = anyTrack(rng);
+                tracks[i] = (runStart + static_cast<int>(i % 64)) % maxTracks;
+                break;
+        }
+    }
+    return tracks;
+}
+
+IORequest makeRequest(int id, int track) {
+    return IORequest{id, 0, track, 0, 0};
+}
+
+// Cost of inserting into a scheduler that already holds `depth` requests
+template <typename Scheduler>
+void benchAddRequest(BenchState& state, Distribution dist, size_t depth) {
+    std::mt19937 rng(1);
+    std::vector<int> tracks = makeTracks(dist, depth * 2, rng);
+    DiskState disk;
+    CostModel cost;
+    RequestPool pool;
+    size_t done = 0;
+    while (done < state.iterations) {
+        Scheduler sched(disk, cost, pool);
+        int id = 0;
+        for (size_t i = 0; i < depth; i++) {
+            sched.addRequest(makeRequest(id++, tracks[i]));
+        }
+        size_t batch = std::min(depth, state.iterations - done);
+        state.resumeTiming();
+        for (size_t i = 0; i < batch; i++) {
+            sched.addRequest(makeRequest(id++, tracks[depth + i]));
+        }
+        state.pauseTiming();
+        done += batch;
+    }
+}
+
+// Cost of a dispatch (getNextRequest via startNextRequest, plus the
+// completion) while the queue holds between depth/2 and depth requests.
+// The head follows each dispatched request, as it does in a simulation.
+template <typename Scheduler>
+void benchGetNextRequest(BenchState& state, Distribution dist, size_t depth) {
+    std::mt19937 rng(2);
+    std::vector<int> tracks = makeTracks(dist, depth, rng);
+    DiskState disk;
+    CostModel cost;
+    RequestPool pool;
+    Scheduler sched(disk, cost, pool);
+    int id = 0;
+    size_t queued = 0;
+    size_t refillAt = depth / 2;
+    for (size_t done = 0; done < state.iterations;) {
+        for (; queued < depth; queued++) {
+            sched.addRequest(makeRequest(id, tracks[id % depth]));
+            id++;
+        }
+        size_t batch = std::min(queued - refillAt, state.iterations - done);
+        state.resumeTiming();
+        for (size_t i = 0; i < batch; i++) {
+            sched.startNextRequest();
+            disk.headPosition = sched.getActiveTrack();
+            sched.completeCurrentRequest();
+        }
+        state.pauseTiming();
+        queued -= batch;
+        done += batch;
+    }
+}
+
+// Cost of the selection routine alone, from random head positions over a
+// queue of `depth` requests
+template <typename Scheduler>
+void benchFindNextRequest(BenchState& state, Distribution dist, size_t depth) {
+    std::mt19937 rng(3);
+    std::vector<int> tracks = makeTracks(dist, depth, rng);
+    std::vector<int> heads = makeTracks(Distribution::Uniform, 4096, rng);
+    DiskState disk;
+    CostModel cost;
+    RequestPool pool;
+    Scheduler sched(disk, cost, pool);
+    for (size_t i = 0; i < depth; i++) {
+        sched.addRequest(makeRequest(static_cast<int>(i), tracks[i]));
+    }
+    if constexpr (std::is_same_v<Scheduler, FLOOK>) {
+        // Move the requests into the active queue, which is what FLOOK searches
+        sched.addRequest(makeRequest(static_cast<int>(depth), tracks[0]));
+        sched.startNextRequest();
+        sched.completeCurrentRequest();
+    }
+    long long checksum = 0;
+    state.resumeTiming();
+    for (size_t i = 0; i < state.iterations; i++) {
+        disk.headPosition = heads[i & 4095];
+        checksum += sched.findNextRequest().track;
+    }
+    state.pauseTiming();
+    if (checksum == -1) std::cerr << checksum; // Keep the lookups from being optimized away
+}
+
+// Whole simulation over a generated trace with Poisson arrivals
+void benchEndToEnd(BenchState& state, char algorithm, Distribution dist, size_t requests) {
+    std::mt19937 rng(4);
+    std::vector<int> tracks = makeTracks(dist, requests, rng, traceMaxTracks);
+    std::exponential_distribution<double> gap(0.01);
+    std::vector<IORequest> trace;
+    double time = 1;
+    for (size_t i = 0; i < requests; i++) {
+        trace.push_back(IORequest{static_cast<int>(i), static_cast<int>(time), tracks[i], 0, 0});
+        time += gap(rng);
+    }
+    for (size_t i = 0; i < state.iterations; i++) {
+        auto sim = Simulator::create(algorithm);
+        VectorTraceSource replay(trace);
+        state.resumeTiming();
+        sim->run(replay);
+        state.pauseTiming();
+    }
+}
+
+// Run a benchmark with growing iteration counts until it takes at least
+// minTime seconds, then report the last run
+BenchResult runBenchmark(const Benchmark& bench, double minTime) {
+    size_t iterations = bench.initialIterations;
+    while (true) {
+        BenchState state(iterations);
+        bench.body(state);
+        double seconds = state.seconds();
+        if (seconds >= minTime || iterations >= (size_t(1) << 40)) {
+            double items = static_cast<double>(iterations) * bench.itemsPerIteration;
+            return {bench.name, iterations, seconds, seconds * 1e9 / items, items / seconds};
+        }
+        double scale = seconds > 0 ? minTime * 1.4 / seconds : 10;
+        iterations = static_cast<size_t>(iterations * std::min(std::max(scale, 1.5), 10.0)) + 1;
+    }
+}
+
+template <typename Scheduler>
+void registerScheduler(std::vector<Benchmark>& benches, const std::string& algo, bool hasFind, size_t maxDepth) {
+    for (Distribution dist : {Distribution::Uniform, Distribution::Hotspot, Distribution::Sequential}) {
+        std::string suffix = algo + "/" + distributionName(dist) + "/";
+        for (size_t depth = 10; depth <= maxDepth; depth *= 10) {
+            benches.push_back({"addRequest/" + suffix + std::to_string(depth), 1,
+                               [=](BenchState& s) { benchAddRequest<Scheduler>(s, dist, depth); }, depth});
+            benches.push_back({"getNextRequest/" + suffix + std::to_string(depth), 1,
+                               [=](BenchState& s) { benchGetNextRequest<Scheduler>(s, dist, depth); }, depth / 2});
+            if constexpr (!std::is_same_v<Scheduler, FIFO>) {
+                if (hasFind) {
+                    benches.push_back({"findNextRequest/" + suffix + std::to_string(depth), 1,
+                                       [=](BenchState& s) { benchFindNextRequest<Scheduler>(s, dist, depth); }});
+                }
+            }
+        }
+    }
+}
+
+void printConsoleHeader() {
+    std::cout << std::left << std::setw(48) << "Benchmark" << std::right << std::setw(14) << "ns/item"
+              << std::setw(14) << "iterations" << std::setw(16) << "items/s" << "\n";
+}
+
+// Console rows are printed as each benchmark finishes
+void printConsoleRow(const BenchResult& r) {
+    std::cout << std::left << std::setw(48) << r.name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(14) << r.nsPerItem << std::setw(14) << r.iterations << std::setw(16)
+              << std::setprecision(0) << r.itemsPerSecond << std::endl;
+}
+
+void printCsv(const std::vector<BenchResult>& results) {
+    std::cout << "name,iterations,seconds,ns_per_item,items_per_second\n";
+    for (const auto& r : results) {
+        std::cout << r.name << "," << r.iterations << "," << std::setprecision(6) << r.seconds << ","
+                  << r.nsPerItem << "," << r.itemsPerSecond << "\n";
+    }
+}
+
+void printJson(const std::vector<BenchResult>& results) {
+    std::cout << "{\n  \"context\": {\"executable\": \"iosched_bench\", \"time_unit\": \"ns\"},\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const auto& r = results[i];
+        std::cout << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+                  << ", \"real_time\": " << std::setprecision(6) << r.nsPerItem
+                  << ", \"cpu_time\": " << r.nsPerItem << ", \"time_unit\": \"ns\""
+                  << ", \"items_per_second\": " << r.itemsPerSecond << "}"
+                  << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    std::cout << "  ]\n}\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    std::string format = "console";
+    double minTime = 0.1;
+    size_t maxDepth = 1000000;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&arg](const std::string& flag) { return arg.substr(flag.size()); };
+        if (arg.rfind("--filter=", 0) == 0) {
+            filter = value("--filter=");
+        } else if (arg.rfind("--format=", 0) == 0) {
+            format = value("--format=");
+        } else if (arg.rfind("--min-time=", 0) == 0) {
+            minTime = std::atof(value("--min-time=").c_str());
+        } else if (arg.rfind("--max-depth=", 0) == 0) {
+            maxDepth = std::strtoull(value("--max-depth=").c_str(), nullptr, 10);
+        } else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--filter=<substring>] [--min-time=<seconds>] [--max-depth=<n>] [--format=console|csv|json]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<Benchmark> benches;
+    registerScheduler<FIFO>(benches, "FIFO", false, maxDepth);
+    registerScheduler<SSTF>(benches, "SSTF", true, maxDepth);
+    registerScheduler<LOOK>(benches, "LOOK", true, maxDepth);
+    registerScheduler<CLOOK>(benches, "CLOOK", true, maxDepth);
+    registerScheduler<FLOOK>(benches, "FLOOK", true, maxDepth);
+    registerScheduler<DEADLINE>(benches, "DEADLINE", true, maxDepth);
+
+    const size_t traceRequests = 100000;
+    const std::pair<char, const char*> algorithms[] = {
+        {'N', "FIFO"}, {'S', "SSTF"}, {'L', "LOOK"}, {'C', "CLOOK"}, {'F', "FLOOK"}, {'D', "DEADLINE"}};
+    for (auto [letter, algo] : algorithms) {
+        for (Distribution dist : {Distribution::Uniform, Distribution::Hotspot, Distribution::Sequential}) {
+            benches.push_back({std::string("endToEnd/") + algo + "/" + distributionName(dist) + "/" +
+                                   std::to_string(traceRequests),
+                               traceRequests,
+                               [=](BenchState& s) { benchEndToEnd(s, letter, dist, traceRequests); }});
+        }
+    }
+
+    if (format != "console" && format != "csv" && format != "json") {
+        std::cerr << "Invalid output format: " << format << "\n";
+        return EXIT_FAILURE;
+    }
+    if (format == "console") {
+        printConsoleHeader();
+    }
+
+    std::vector<BenchResult> results;
+    for (const auto& bench : benches) {
+        if (!filter.empty() && bench.name.find(filter) == std::string::npos) continue;
+        results.push_back(runBenchmark(bench, minTime));
+        if (format == "console") {
+            printConsoleRow(results.back());
+        }
+    }
+
+    if (format == "json") {
+        printJson(results);
+    } else if (format == "csv") {
+        printCsv(results);
+    }
+    return 0;
+}
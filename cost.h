@@ -0,0 +1,132 @@
+#ifndef COST_H
+#define COST_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+// Time the disk needs to service one request. All times are in simulation
+// time units.
+//
+// A seek of d > 0 tracks costs settle + seekSqrt * sqrt(d) while the arm is
+// still accelerating (d <= coastDistance), and beyond that continues
+// linearly at seekLinear per track. Rotational latency is the wait for the
+// request's sector to come under the head once the seek ends, and transfer
+// takes transferSectors / sectorsPerTrack of a revolution.
+//
+// The defaults charge exactly one time unit per track moved and nothing
+// else, which is the model the reference outputs in tests/ were made with.
+struct CostModel {
+    double settle = 0;
+    double seekSqrt = 0;
+    double seekLinear = 1;
+    int coastDistance = 0;
+    double rotation = 0;       // Time of one revolution; 0 disables rotation and transfer
+    int sectorsPerTrack = 1;
+    int transferSectors = 0;   // Sectors read or written per request
+
+    bool hasRotation() const {
+        return rotation > 0;
+    }
+
+    double seekTime(int64_t distance) const {
+        if (distance <= 0) {
+            return 0;
+        }
+        if (distance <= coastDistance) {
+            return settle + seekSqrt * std::sqrt(distance);
+        }
+        return settle + seekSqrt * std::sqrt(coastDistance) + seekLinear * static_cast<double>(distance - coastDistance);
+    }
+
+    // Traces carry no sector numbers, so each request's angular position
+    // (a fraction of a revolution) is derived from a hash of its id
+    static double sectorAngle(int id) {
+        uint64_t h = static_cast<uint64_t>(id) + 0x9E3779B97F4A7C15ULL;
+        h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+        h ^= h >> 31;
+        return static_cast<double>(h >> 11) / static_cast<double>(1ULL << 53);
+    }
+
+    // Wait at time `when` until the request's sector reaches the head
+    double rotationalLatency(int id, double when) const {
+        if (!hasRotation()) {
+            return 0;
+        }
+        double headAngle = std::fmod(when, rotation) / rotation;
+        double wait = sectorAngle(id) - headAngle;
+        if (wait < 0) wait += 1;
+        return wait * rotation;
+    }
+
+    double transferTime() const {
+        return hasRotation() ? rotation * transferSectors / sectorsPerTrack : 0;
+    }
+
+    // Seek plus rotational latency for a request dispatched at `now` with
+    // the head on `fromTrack`
+    double positioningTime(int fromTrack, int toTrack, int id, int64_t now) const {
+        double seek = seekTime(std::abs(static_cast<int64_t>(toTrack) - fromTrack));
+        return seek + rotationalLatency(id, now + seek);
+    }
+
+    // Whole service time, rounded up to the simulation clock
+    int64_t serviceTime(int fromTrack, int toTrack, int id, int64_t now) const {
+        return static_cast<int64_t>(std::ceil(positioningTime(fromTrack, toTrack, id, now) + transferTime()));
+    }
+};
+
+// Load a cost model preset. Each line is "key = value"; '#' starts a
+// comment line. Keys not given keep the one-unit-per-track defaults.
+inline bool loadCostModel(const std::string& filename, CostModel& model) {
+    std::ifstream file(filename);
+    if (!file) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') continue; // Skip empty lines and comments
+
+        size_t eq = line.find('=');
+        std::string key;
+        if (eq != std::string::npos) {
+            std::istringstream(line.substr(0, eq)) >> key;
+        }
+        std::istringstream value(eq == std::string::npos ? "" : line.substr(eq + 1));
+        bool ok;
+        if (key == "settle") ok = static_cast<bool>(value >> model.settle);
+        else if (key == "seek_sqrt") ok = static_cast<bool>(value >> model.seekSqrt);
+        else if (key == "seek_linear") ok = static_cast<bool>(value >> model.seekLinear);
+        else if (key == "coast_distance") ok = static_cast<bool>(value >> model.coastDistance);
+        else if (key == "rotation") ok = static_cast<bool>(value >> model.rotation);
+        else if (key == "sectors_per_track") ok = static_cast<bool>(value >> model.sectorsPerTrack);
+        else if (key == "transfer_sectors") ok = static_cast<bool>(value >> model.transferSectors);
+        else {
+            std::cerr << filename << ":" << lineNumber << ": unknown cost model setting '" << key << "'\n";
+            return false;
+        }
+        if (!ok) {
+            std::cerr << filename << ":" << lineNumber << ": invalid value for " << key << "\n";
+            return false;
+        }
+    }
+
+    if (model.settle < 0 || model.seekSqrt < 0 || model.seekLinear < 0 || model.coastDistance < 0 ||
+        model.rotation < 0 || model.sectorsPerTrack < 1 || model.transferSectors < 0) {
+        std::cerr << filename << ": cost model settings out of range\n";
+        return false;
+    }
+    return true;
+}
+
+#endif // COST_H
@@ -0,0 +1,199 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <random>
+#include <cmath>
+#include <climits>
+#include <numeric>
+
+#include "iosched.h"
+
+// Parameters of a synthetic workload. Arrivals are Poisson with rate
+// `lambda` per time unit, except for the bursty distribution, which keeps
+// the same mean rate but groups arrivals into bursts.
+struct GeneratorSpec {
+    long long numio = 10000;
+    int maxtracks = 128;
+    double lambda = 0.1;
+    std::string dist = "uniform"; // uniform, zipf, hotspot, sequential or bursty
+    double skew = 1.0;            // zipf: exponent of the rank distribution
+    double hotfrac = 0.9;         // hotspot: share of accesses that go to the hot region
+    double hotsize = 0.1;         // hotspot: hot region as a share of all tracks
+    int runlen = 64;              // sequential: consecutive tracks per run
+    int burst = 16;               // bursty: requests per burst
+    unsigned seed = 1;
+};
+
+// Parse "key=value,key=value,..." into a generator spec. The keys are the
+// field names of GeneratorSpec.
+inline bool parseGeneratorSpec(const std::string& text, GeneratorSpec& spec) {
+    std::istringstream items(text);
+    std::string item;
+    while (std::getline(items, item, ',')) {
+        if (item.empty()) continue;
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << "Invalid generator setting: " << item << "\n";
+            return false;
+        }
+        std::string key = item.substr(0, eq);
+        std::istringstream value(item.substr(eq + 1));
+        bool ok;
+        if (key == "numio") ok = static_cast<bool>(value >> spec.numio);
+        else if (key == "maxtracks") ok = static_cast<bool>(value >> spec.maxtracks);
+        else if (key == "lambda") ok = static_cast<bool>(value >> spec.lambda);
+        else if (key == "dist") ok = static_cast<bool>(value >> spec.dist);
+        else if (key == "skew") ok = static_cast<bool>(value >> spec.skew);
+        else if (key == "hotfrac") ok = static_cast<bool>(value >> spec.hotfrac);
+        else if (key == "hotsize") ok = static_cast<bool>(value >> spec.hotsize);
+        else if (key == "runlen") ok = static_cast<bool>(value >> spec.runlen);
+        else if (key == "burst") ok = static_cast<bool>(value >> spec.burst);
+        else if (key == "seed") ok = static_cast<bool>(value >> spec.seed);
+        else {
+            std::cerr << "Unknown generator setting: " << key << "\n";
+            return false;
+        }
+        if (!ok) {
+            std::cerr << "Invalid value for generator setting " << key << "\n";
+            return false;
+        }
+    }
+
+    if (spec.dist != "uniform" && spec.dist != "zipf" && spec.dist != "hotspot" &&
+        spec.dist != "sequential" && spec.dist != "bursty") {
+        std::cerr << "Unknown generator distribution: " << spec.dist << "\n";
+        return false;
+    }
+    if (spec.numio < 0 || spec.numio > INT_MAX || spec.maxtracks < 1 || spec.lambda <= 0 || spec.skew <= 0 || spec.hotfrac < 0 ||
+        spec.hotfrac > 1 || spec.hotsize <= 0 || spec.hotsize > 1 || spec.runlen < 1 || spec.burst < 1) {
+        std::cerr << "Generator settings out of range\n";
+        return false;
+    }
+    return true;
+}
+
+// Zipf-distributed ranks in [1, n] by rejection-inversion (Hörmann and
+// Derflinger), so sampling takes constant time and memory for any n
+class ZipfSampler {
+private:
+    double exponent;
+    double n;
+    double hIntegralX1;
+    double hIntegralN;
+    double s;
+
+    // log1p(x) / x and expm1(x) / x, continuous at 0
+    static double helper1(double x) { return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1 - x / 2; }
+    static double helper2(double x) { return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1 + x / 2; }
+
+    double h(double x) const { return std::exp(-exponent * std::log(x)); }
+
+    double hIntegral(double x) const {
+        double logX = std::log(x);
+        return helper2((1 - exponent) * logX) * logX;
+    }
+
+    double hIntegralInverse(double x) const {
+        double t = std::max(x * (1 - exponent), -1.0);
+        return std::exp(helper1(t) * x);
+    }
+
+public:
+    ZipfSampler(long long numElements, double zipfExponent) : exponent(zipfExponent), n(numElements) {
+        hIntegralX1 = hIntegral(1.5) - 1;
+        hIntegralN = hIntegral(n + 0.5);
+        s = 2 - hIntegralInverse(hIntegral(2.5) - h(2));
+    }
+
+    template <typename Rng>
+    long long operator()(Rng& rng) {
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        while (true) {
+            double u = hIntegralN + unit(rng) * (hIntegralX1 - hIntegralN);
+            double x = hIntegralInverse(u);
+            long long k = static_cast<long long>(x + 0.5);
+            k = std::min<long long>(std::max<long long>(k, 1), static_cast<long long>(n));
+            if (k - x <= s || u >= hIntegral(k + 0.5) - h(static_cast<double>(k))) {
+                return k;
+            }
+        }
+    }
+};
+
+// Streams a synthetic workload into the simulator without materializing it
+class TraceGenerator : public TraceSource {
+private:
+    GeneratorSpec spec;
+    std::mt19937_64 rng;
+    ZipfSampler zipf;
+    long long produced = 0;
+    double clock = 1;       // Arrival time of the next request, before rounding
+    int runTrack = 0;       // sequential: next track of the current run
+    int burstCenter = 0;    // bursty: track the current burst clusters around
+    long long zipfStride;   // Scatters Zipf ranks over the disk
+
+    int uniformTrack() {
+        return std::uniform_int_distribution<int>(0, spec.maxtracks - 1)(rng);
+    }
+
+    double gap(double rate) {
+        return std::exponential_distribution<double>(rate)(rng);
+    }
+
+public:
+    explicit TraceGenerator(const GeneratorSpec& genSpec)
+        : spec(genSpec), rng(genSpec.seed), zipf(genSpec.maxtracks, genSpec.skew) {
+        // Any stride coprime with maxtracks turns rank order into a permutation
+        zipfStride = std::max<long long>(1, static_cast<long long>(spec.maxtracks * 0.6180339887));
+        while (std::gcd(zipfStride, static_cast<long long>(spec.maxtracks)) != 1) zipfStride++;
+    }
+
+    bool next(IORequest& req) override {
+        if (produced >= spec.numio) {
+            return false;
+        }
+
+        int track;
+        if (spec.dist == "zipf") {
+            track = static_cast<int>((zipf(rng) - 1) * zipfStride % spec.maxtracks);
+        } else if (spec.dist == "hotspot") {
+            int hotTracks = std::max(1, static_cast<int>(spec.maxtracks * spec.hotsize));
+            bool hot = std::uniform_real_distribution<double>(0.0, 1.0)(rng) < spec.hotfrac;
+            track = hot ? std::uniform_int_distribution<int>(0, hotTracks - 1)(rng) : uniformTrack();
+        } else if (spec.dist == "sequential") {
+            if (produced % spec.runlen == 0) runTrack = uniformTrack();
+            track = runTrack;
+            runTrack = (runTrack + 1) % spec.maxtracks;
+        } else if (spec.dist == "bursty") {
+            // Each burst lands on a neighborhood of 1% of the disk
+            if (produced % spec.burst == 0) burstCenter = uniformTrack();
+            int spread = std::max(1, spec.maxtracks / 100);
+            track = burstCenter + std::uniform_int_distribution<int>(-spread, spread)(rng);
+            track = std::min(std::max(track, 0), spec.maxtracks - 1);
+        } else {
+            track = uniformTrack();
+        }
+
+        req.id = static_cast<int>(produced);
+        req.arrivalTime = static_cast<int64_t>(clock);
+        req.track = track;
+        req.startTime = 0;
+        req.endTime = 0;
+        produced++;
+
+        if (spec.dist == "bursty") {
+            // Long quiet gap before each burst, short gaps inside it; the mean
+            // rate over a whole burst stays close to lambda
+            bool burstStart = produced % spec.burst == 0;
+            clock += burstStart ? gap(spec.lambda / spec.burst) : gap(spec.lambda * spec.burst);
+        } else {
+            clock += gap(spec.lambda);
+        }
+        return true;
+    }
+};
+
+#endif // GENERATOR_H
@@ -0,0 +1,127 @@
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+
+#include <iostream>
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+#include "snapshot.h"
+
+// Log-bucketed histogram of non-negative 64-bit values in the style of
+// HdrHistogram. Values below 128 get a bucket each; above that every
+// power-of-two range is split into 64 buckets, so a reported value is within
+// 1.6% of the true one. The bucket array has a fixed size covering the whole
+// range, so memory does not grow with the number of values recorded.
+class Histogram {
+public:
+    static constexpr int subBits = 6;
+    static constexpr int subCount = 1 << subBits; // Buckets per power of two
+    static constexpr int bucketCount = (64 - subBits) * subCount;
+
+private:
+    std::array<uint64_t, bucketCount> counts{};
+    uint64_t total = 0;
+    int64_t maxValue = 0;
+
+    struct Bucket {
+        int index;
+        uint64_t count;
+
+        auto fields() { return std::tie(index, count); }
+    };
+
+public:
+    static int bucketIndex(int64_t value) {
+        if (value < 2 * subCount) {
+            return static_cast<int>(std::max<int64_t>(value, 0));
+        }
+        int msb = 63 - __builtin_clzll(static_cast<uint64_t>(value));
+        int shift = msb - subBits;
+        return shift * subCount + static_cast<int>(value >> shift);
+    }
+
+    // Smallest and largest value that land in a bucket
+    static int64_t bucketLow(int index) {
+        int shift = index < 2 * subCount ? 0 : index / subCount - 1;
+        return static_cast<int64_t>(index - shift * subCount) << shift;
+    }
+
+    static int64_t bucketHigh(int index) {
+        int shift = index < 2 * subCount ? 0 : index / subCount - 1;
+        return bucketLow(index) + ((int64_t(1) << shift) - 1);
+    }
+
+    void record(int64_t value) {
+        counts[bucketIndex(value)]++;
+        total++;
+        maxValue = std::max(maxValue, value);
+    }
+
+    void merge(const Histogram& other) {
+        for (int i = 0; i < bucketCount; i++) {
+            counts[i] += other.counts[i];
+        }
+        total += other.total;
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    // Only the non-empty buckets are written
+    void save(SnapshotWriter& out) const {
+        std::vector<Bucket> used;
+        for (int i = 0; i < bucketCount; i++) {
+            if (counts[i] != 0) used.push_back({i, counts[i]});
+        }
+        out.putVector(used);
+        out.put(total);
+        out.put(maxValue);
+    }
+
+    void restore(SnapshotReader& in) {
+        std::vector<Bucket> used;
+        in.getVector(used);
+        counts.fill(0);
+        for (const auto& bucket : used) {
+            if (bucket.index >= 0 && bucket.index < bucketCount) counts[bucket.index] = bucket.count;
+        }
+        in.get(total);
+        in.get(maxValue);
+    }
+
+    uint64_t count() const { return total; }
+    int64_t max() const { return maxValue; }
+
+    // Smallest value with at least the given fraction of all values at or
+    // below it, reported as the top of its bucket
+    int64_t percentile(double fraction) const {
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(fraction * total)));
+        uint64_t seen = 0;
+        for (int i = 0; i < bucketCount; i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(bucketHigh(i), maxValue);
+            }
+        }
+        return maxValue;
+    }
+
+    // {"count":N,"max":M,"buckets":[[low,high,count],...]}, non-empty buckets only
+    void writeJson(std::ostream& out) const {
+        out << "{\"count\":" << total << ",\"max\":" << maxValue << ",\"buckets\":[";
+        bool first = true;
+        for (int i = 0; i < bucketCount; i++) {
+            if (counts[i] == 0) continue;
+            out << (first ? "" : ",") << "[" << bucketLow(i) << "," << bucketHigh(i) << "," << counts[i] << "]";
+            first = false;
+        }
+        out << "]}";
+    }
+};
+
+#endif // HISTOGRAM_H
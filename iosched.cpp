@@ -1,691 +1,456 @@
 #include <iostream>
 #include <vector>
 #include <string>
-#include <fstream>
-#include <queue>
 #include <sstream>
-#include <memory>  
-#include <queue>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+#include <cctype>
+#include <fstream>
 #include <chrono>
-#include <cmath>
-#include <iomanip>
-#include <numeric> 
-#include <algorithm> 
-#include <list>
-#include <iterator>
-#include <cmath>
-#include <climits> 
 #include <unistd.h>
 
+#include "iosched.h"
+#include "trace.h"
+#include "parallel.h"
+#include "sweep.h"
+#include "generator.h"
+#include "array.h"
+#include "cost.h"
+
+// Expand a -s argument: a single letter, "all", or a comma-separated list.
+// Letters may be given in either case.
+std::string parseSchedulerList(const std::string& arg) {
+    if (arg == "all") {
+        return "NSLCFD";
+    }
+    std::string types;
+    std::istringstream iss(arg);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        if (!item.empty()) {
+            types += static_cast<char>(std::toupper(static_cast<unsigned char>(item[0])));
+        }
+    }
+    return types;
+}
 
-int currentTime = 0;
-int currentHeadPosition = 0; 
-int totalTrack = 0;
-int totalBusyTime = 0;
-int direction = 1;
-int total_movement = 0;
-
-// Define an IO request struct
-struct IORequest {
-    int id; // Unique identifier for the request
-    int arrivalTime;
-    int track;
-    int startTime; // When the request actually starts processing
-    int endTime;   // When the request completesx
-};
-
-// Abstract class for IO Scheduling Algorithms
-class IOScheduler {
-public:
-    // Virtual destructor for safe polymorphic deletion
-    virtual ~IOScheduler() {}
-
-    // Add a request to the scheduler
-    virtual void addRequest(IORequest req) = 0;
-
-    // Get the next request, potentially activating it
-    virtual IORequest getNextRequest() = 0;
-
-    // Check if the scheduler has pending requests
-    virtual bool hasRequests() const = 0;
-
-    // Check if there is currently an active I/O operation
-    virtual bool isActive() const = 0;
-
-    virtual int getActiveTrack() const  = 0;
-
-    virtual bool isComplete(int currentTime) const = 0;
-
-    // Marks the current active request as completed
-    virtual void completeCurrentRequest() = 0;
-
-    // Method to simulate the movement of the disk head
-    // virtual void moveHead() = 0;
-
-    virtual void startNextRequest() = 0;
-
-    virtual const std::vector<IORequest>& getCompletedRequests() const  = 0;
-};
-
-// FIFO scheduling algorithm implementation
-class FIFO : public IOScheduler {
-private:
-    std::queue<IORequest> requestQueue;     // Queue to hold incoming requests
-    bool currentActive = false;             // Flag to check if a request is currently being processed
-    IORequest activeRequest;                // The request currently being processed
-    std::vector<IORequest> completedRequests;   
-
-public:
-    void addRequest(IORequest req) override {
-        requestQueue.push(req);
-    }
-
-    IORequest getNextRequest() override {
-        if (!requestQueue.empty() && !currentActive) {  // Only fetch next request if no active request
-            activeRequest = requestQueue.front();
-            requestQueue.pop();
-            activeRequest.startTime = currentTime;
-            currentActive = true;
-            return activeRequest;
-        }
-        return IORequest{}; // Return an empty request if one is active
-    }
-
-    bool hasRequests() const override {
-        return !requestQueue.empty() || currentActive;
-    }
-
-    bool isActive() const override {
-        return currentActive;
-    }
+// Main function that sets up and runs the simulation
+int main(int argc, char* argv[]) {
+    std::string inputFileName;
+    std::string binaryOutputName;  // Convert the input to a binary trace instead of simulating
+    std::string schedulerTypes = "N";  // Default scheduler type set to 'N' for FIFO
+    std::string sweepSpecName;     // Run a parameter sweep instead of a single trace
+    std::string sweepFormat = "csv";
+    std::string generatorSpec;     // Simulate a synthetic workload instead of an input file
+    int deviceCount = 1;           // Devices in the simulated array
+    PlacementPolicy placement;     // How tracks are spread over the devices
+    CostModel cost;                // Service time model; one time unit per track by default
+    bool printLatency = false;     // Print wait/turnaround/seek percentiles
+    std::string histogramName;     // Dump the latency histograms as JSON
+    SchedulerTuning tuning;        // Deadline and batch size of the deadline scheduler
+    int liveInterval = -1;         // Stream completions, with running totals every this many time units
+    std::string checkpointName;    // Snapshot the run to this file every checkpointInterval time units
+    int checkpointInterval = 1000000;
+    std::string resumeName;        // Carry on from a snapshot instead of starting at time 0
+    int opt;
 
-    int getActiveTrack() const {
-        if (currentActive) {
-            return activeRequest.track;
+    while ((opt = getopt(argc, argv, "s:c:g:F:G:D:P:M:pj:d:mL:a:Q:K:R:")) != -1) {
+        switch (opt) {
+            case 's':
+                schedulerTypes = parseSchedulerList(optarg);
+                break;
+            case 'c':
+                binaryOutputName = optarg;
+                break;
+            case 'g':
+                sweepSpecName = optarg;
+                break;
+            case 'F':
+                sweepFormat = optarg;
+                break;
+            case 'G':
+                generatorSpec = optarg;
+                break;
+            case 'D':
+                deviceCount = std::atoi(optarg);
+                if (deviceCount < 1) {
+                    std::cerr << "Invalid device count: " << optarg << "\n";
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'P':
+                if (!parsePlacementPolicy(optarg, placement)) {
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'M':
+                if (!loadCostModel(optarg, cost)) {
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'p':
+                printLatency = true;
+                break;
+            case 'j':
+                histogramName = optarg;
+                break;
+            case 'm':
+                tuning.coalesce = true;
+                break;
+            case 'd': {
+                // <deadline>[:<batch>]
+                char* end;
+                tuning.deadline = std::strtol(optarg, &end, 10);
+                if (*end == ':') tuning.fifoBatch = std::strtol(end + 1, &end, 10);
+                if (*end != '\0' || tuning.deadline < 0 || tuning.fifoBatch < 1) {
+                    std::cerr << "Invalid deadline: " << optarg << "\n";
+                    return EXIT_FAILURE;
+                }
+                break;
+            }
+            case 'a': {
+                // <window>[:<tracks>]
+                char* end;
+                tuning.anticipation = std::strtol(optarg, &end, 10);
+                if (*end == ':') tuning.anticipationTracks = std::strtol(end + 1, &end, 10);
+                if (*end != '\0' || tuning.anticipation < 1 || tuning.anticipationTracks < 0) {
+                    std::cerr << "Invalid anticipation window: " << optarg << "\n";
+                    return EXIT_FAILURE;
+                }
+                break;
+            }
+            case 'Q':
+                tuning.queueDepth = std::atoi(optarg);
+                if (tuning.queueDepth < 1) {
+                    std::cerr << "Invalid queue depth: " << optarg << "\n";
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'K': {
+                // <file>[:<interval>]
+                checkpointName = optarg;
+                size_t colon = checkpointName.rfind(':');
+                if (colon != std::string::npos) {
+                    char* end;
+                    checkpointInterval = std::strtol(checkpointName.c_str() + colon + 1, &end, 10);
+                    checkpointName.resize(colon);
+                    if (*end != '\0' || checkpointInterval < 1 || checkpointName.empty()) {
+                        std::cerr << "Invalid checkpoint: " << optarg << "\n";
+                        return EXIT_FAILURE;
+                    }
+                }
+                break;
+            }
+            case 'R':
+                resumeName = optarg;
+                break;
+            case 'L': {
+                char* end;
+                liveInterval = std::strtol(optarg, &end, 10);
+                if (*end != '\0' || liveInterval < 0) {
+                    std::cerr << "Invalid live interval: " << optarg << "\n";
+                    return EXIT_FAILURE;
+                }
+                break;
+            }
+            default:
+                std::cerr << "Usage: " << argv[0] << " [-s <schedalgo>|all|<a,b,...>] [-c <binaryfile>] [-D <devices> [-P <placement>]] [-M <costfile>] [-p] [-j <histfile>] [-d <deadline>[:<batch>]] [-m] [-a <window>[:<tracks>]] [-Q <depth>] [-L <interval>] [-K <file>[:<interval>]] [-R <file>] <inputfile>|-\n"
+                          << "       " << argv[0] << " [-s ...] [-c <binaryfile>] -G <key=value,...>\n"
+                          << "       " << argv[0] << " -g <gridfile> [-F csv|json]\n";
+                return EXIT_FAILURE;
         }
-        return -1; // Return an invalid track number if no active request
-    }
-
-    bool isComplete(int currentTime) const override {
-        return currentActive && (currentHeadPosition == activeRequest.track); 
     }
 
-    void completeCurrentRequest() override {
-        if (currentActive) {
-            activeRequest.endTime = currentTime;
-            completedRequests.push_back(activeRequest);
-            currentActive = false;
+    if (!sweepSpecName.empty()) {
+        if (sweepFormat != "csv" && sweepFormat != "json") {
+            std::cerr << "Invalid sweep output format: " << sweepFormat << "\n";
+            return EXIT_FAILURE;
         }
-    }
-
-    void startNextRequest() override {
-        if (!currentActive && !requestQueue.empty()) {
-            getNextRequest();  // Start the next request only if there is no active request
+        SweepSpec spec;
+        std::vector<SweepResult> results;
+        if (!readSweepSpec(sweepSpecName, spec) || !runSweep(spec, results)) {
+            return EXIT_FAILURE;
         }
-    }
-
-    const std::vector<IORequest>& getCompletedRequests() const {
-        return completedRequests;
-    }
-};
-
-// SSTF scheduling algorithm implementation
-class SSTF : public IOScheduler {
-private:
-    std::list<IORequest> requestList; // List to hold all pending requests
-    bool currentActive = false;       // Flag to check if there is an active request
-    IORequest activeRequest;          // Stores the current active request
-    std::vector<IORequest> completedRequests; // List of completed requests for statistics
-
-public:
-    // Adding a new IO request to the pool
-    void addRequest(IORequest req) override {
-        requestList.push_back(req);
-    }
-
-    // Fetching the next request based on the shortest seek time
-    IORequest getNextRequest() override {
-        if (!requestList.empty() && !currentActive) {
-            auto it = std::min_element(requestList.begin(), requestList.end(),
-                [this](const IORequest& a, const IORequest& b) {
-                    return std::abs(a.track - currentHeadPosition) < std::abs(b.track - currentHeadPosition);
-                });
-
-            activeRequest = *it;
-            requestList.erase(it);  // Remove the request from the pool
-            activeRequest.startTime = currentTime;  // Set the start time for the request
-            currentActive = true;
-            return activeRequest;
+        if (sweepFormat == "json") {
+            writeSweepJson(std::cout, results);
+        } else {
+            writeSweepCsv(std::cout, results);
         }
-        return IORequest{};  // Return an empty request if there's already an active request
-    }
-
-    // Check if there are pending requests or an active request
-    bool hasRequests() const override {
-        return !requestList.empty() || currentActive;
-    }
-
-    // Check if there's an active request
-    bool isActive() const override {
-        return currentActive;
+        return 0;
     }
 
-    // Retrieve the track of the active request
-    int getActiveTrack() const override {
-        if (currentActive) {
-            return activeRequest.track;
+    std::unique_ptr<TraceSource> trace;
+    if (!generatorSpec.empty()) {
+        GeneratorSpec spec;
+        if (!parseGeneratorSpec(generatorSpec, spec)) {
+            return EXIT_FAILURE;
         }
-        return -1;
-    }
-
-    // Determine if the current request has completed
-    bool isComplete(int currentTime) const override {
-        return currentActive && (currentHeadPosition == activeRequest.track);
-    }
-
-    // Mark the current request as completed
-    void completeCurrentRequest() override {
-        if (currentActive) {
-            activeRequest.endTime = currentTime;
-            completedRequests.push_back(activeRequest);
-            currentActive = false;
+        trace = std::make_unique<TraceGenerator>(spec);
+    } else {
+        // The input file should be the next argument after the options
+        if (optind < argc) {
+            inputFileName = argv[optind];
+        } else {
+            std::cerr << "Expected input file\n";
+            return EXIT_FAILURE;
         }
-    }
 
-    // Attempt to start the next request if no current active request
-    void startNextRequest() override {
-        if (!currentActive && !requestList.empty()) {
-            getNextRequest();
+        trace = openTrace(inputFileName);
+        if (!trace) {
+            return EXIT_FAILURE;
         }
     }
 
-    // Access completed requests for statistics
-    const std::vector<IORequest>& getCompletedRequests() const override {
-        return completedRequests;
-    }
-};
-
-// LOOK scheduling algorithm implementation
-class LOOK : public IOScheduler {
-private:
-    std::list<IORequest> requests; // A list to hold all pending requests
-    bool currentActive = false;
-    IORequest activeRequest;
-    std::vector<IORequest> completedRequests;
-    int direction = 1; // 1 for increasing track numbers, -1 for decreasing
-
-public:
-    // Add a new IO request to the pool
-    void addRequest(IORequest req) override {
-        requests.push_back(req);
-        requests.sort([](const IORequest& a, const IORequest& b) { return a.track < b.track; }); // Keep list sorted by track number for LOOK efficiency
-    }
-
-    // Fetching the next request based on LOOK strategy
-    IORequest getNextRequest() override {
-        if (!requests.empty() && !currentActive) {
-            auto it = findNextRequest();
-            if (it != requests.end()) {
-                activeRequest = *it;
-                requests.erase(it);
-                activeRequest.startTime = currentTime;
-                currentActive = true;
-                return activeRequest;
-            }
+    if (!binaryOutputName.empty()) {
+        long long written = writeBinaryTrace(*trace, binaryOutputName);
+        if (written < 0) {
+            std::cerr << "Error writing binary trace: " << binaryOutputName << std::endl;
+            return EXIT_FAILURE;
         }
-        return IORequest{}; // Return an empty request if no appropriate one is found
+        std::cout << "Wrote " << written << " requests to " << binaryOutputName << std::endl;
+        return 0;
     }
 
-    // Helper function to find the next request in the current direction
-    std::list<IORequest>::iterator findNextRequest() {
-        std::list<IORequest>::iterator selected = requests.end();
-        int distance = INT_MAX;
+    if ((!checkpointName.empty() || !resumeName.empty()) && schedulerTypes.size() > 1) {
+        std::cerr << "Checkpoints cover a single algorithm\n";
+        return EXIT_FAILURE;
+    }
 
-        for (auto it = requests.begin(); it != requests.end(); ++it) {
-            int dist = std::abs(it->track - currentHeadPosition);
-            if ((direction == 1 && it->track >= currentHeadPosition) || 
-            (direction == -1 && it->track <= currentHeadPosition)) {
-                if (dist < distance) {
-                    distance = dist;
-                    selected = it;
-                }
-            }
+    // Instantiate the appropriate schedulers
+    std::vector<std::unique_ptr<Simulator>> simulators;
+    for (char schedulerType : schedulerTypes) {
+        simulators.push_back(Simulator::create(schedulerType, cost, tuning));
+        if (!simulators.back() && tuning.anticipation > 0 && tuning.queueDepth > 1) {
+            std::cerr << "Anticipation needs to see completions and cannot be combined with a device queue\n";
+            return EXIT_FAILURE;
         }
-
-        // If no request found in the current direction, change direction
-        if (selected == requests.end()) {
-            direction = -direction; // Reverse the direction
-            return findNextRequest(); // Recursive call to find in the new direction
+        if (!simulators.back()) {
+            std::cerr << "Invalid scheduler type specified: " << schedulerType << "\n";
+            return EXIT_FAILURE;
         }
-
-        return selected;
     }
-
-    // Check if there are pending requests or an active request
-    bool hasRequests() const override {
-        return !requests.empty() || currentActive;
-    }
-
-    // Check if there's an active request
-    bool isActive() const override {
-        return currentActive;
+    if (simulators.empty()) {
+        std::cerr << "Expected at least one scheduler\n";
+        return EXIT_FAILURE;
     }
 
-    // Retrieve the track of the active request
-    int getActiveTrack() const override {
-        if (currentActive) {
-            return activeRequest.track;
+    // Array mode: one scheduler instance and head per device
+    std::vector<std::unique_ptr<DiskArray>> arrays;
+    if (deviceCount > 1) {
+        for (char schedulerType : schedulerTypes) {
+            arrays.push_back(DiskArray::create(schedulerType, deviceCount, placement, cost, tuning));
         }
-        return -1;
-    }
-
-    // Determine if the current request has completed
-    bool isComplete(int currentTime) const override {
-        return currentActive && (currentHeadPosition == activeRequest.track);
     }
 
-    // Mark the current request as completed
-    void completeCurrentRequest() override {
-        if (currentActive) {
-            activeRequest.endTime = currentTime;
-            completedRequests.push_back(activeRequest);
-            currentActive = false;
+    std::ofstream histogramFile;
+    if (!histogramName.empty()) {
+        histogramFile.open(histogramName);
+        if (!histogramFile) {
+            std::cerr << "Error opening file: " << histogramName << std::endl;
+            return EXIT_FAILURE;
         }
     }
-
-    // Attempt to start the next request if no current active request
-    void startNextRequest() override {
-        if (!currentActive && !requests.empty()) {
-            getNextRequest();
+    auto latencyOf = [&](size_t i) {
+        return arrays.empty() ? simulators[i]->latencyHistograms() : arrays[i]->latencyHistograms();
+    };
+    auto mergesOf = [&](size_t i) {
+        return arrays.empty() ? simulators[i]->merges() : arrays[i]->merges();
+    };
+    auto waitsOf = [&](size_t i) {
+        return arrays.empty() ? simulators[i]->queueWaits() : arrays[i]->queueWaits();
+    };
+
+    // Profiling builds end with the phase table of every algorithm on
+    // stderr, then the same times as folded stacks
+    auto printProfile = [&]() {
+#ifdef IOSCHED_PROFILE
+        auto countersOf = [&](size_t i) {
+            return arrays.empty() ? simulators[i]->profileCounters() : arrays[i]->profileCounters();
+        };
+        for (size_t i = 0; i < simulators.size(); i++) {
+            profile::printReport(std::cerr, std::string(1, schedulerTypes[i]), countersOf(i));
+        }
+        for (size_t i = 0; i < simulators.size(); i++) {
+            profile::printFolded(std::cerr, std::string(1, schedulerTypes[i]), countersOf(i));
+        }
+#endif
+    };
+
+    // Live mode: print each request as it completes and, every liveInterval
+    // time units, an "AT <time> <completed> SUM: ..." line with the totals so far
+    long long nextReport = liveInterval;
+    auto emit = [&](const IORequest& req) {
+        printRequestLine(req);
+        if (liveInterval > 0 && req.endTime >= nextReport) {
+            long long completed = arrays.empty() ? simulators[0]->completedCount() : arrays[0]->completedCount();
+            std::cout << "AT " << req.endTime << " " << completed << " ";
+            printSummary(std::cout, arrays.empty() ? simulators[0]->statistics() : arrays[0]->statistics());
+            std::cout.flush();
+            nextReport = (req.endTime / liveInterval + 1) * static_cast<long long>(liveInterval);
+        }
+    };
+    if (liveInterval >= 0) {
+        if (simulators.size() > 1) {
+            std::cerr << "Live mode runs a single algorithm\n";
+            return EXIT_FAILURE;
         }
-    }
-
-    // Access completed requests for statistics
-    const std::vector<IORequest>& getCompletedRequests() const override {
-        return completedRequests;
-    }
-};
-
-// CLOOK scheduling algorithm implementation
-class CLOOK : public IOScheduler {
-private:
-    std::list<IORequest> requestList; // List to hold all pending requests
-    bool currentActive = false;       // Flag to check if there is an active request
-    IORequest activeRequest;          // Stores the current active request
-    std::vector<IORequest> completedRequests; // List of completed requests for statistics
-
-public:
-    // Adding a new IO request to the pool
-    void addRequest(IORequest req) override {
-        requestList.push_back(req);
-        requestList.sort([](const IORequest& a, const IORequest& b) { return a.track < b.track; });
-    }
-
-    // Fetching the next request based on C-LOOK strategy
-    IORequest getNextRequest() override {
-        if (!requestList.empty() && !currentActive) {
-            // If we are at the end or the next request would be in the opposite direction
-            auto it = std::find_if(requestList.begin(), requestList.end(),
-                                   [this](const IORequest& req) { return req.track >= currentHeadPosition; });
-            
-            if (it == requestList.end()) {  // If no suitable request is found, wrap around
-                it = requestList.begin();
-            }
-
-            activeRequest = *it;
-            requestList.erase(it);  // Remove the request from the pool
-            activeRequest.startTime = currentTime;  // Set the start time for the request
-            currentActive = true;
-            return activeRequest;
+        if (tuning.anticipation > 0) {
+            std::cerr << "Anticipation is measured against a second run, which live mode cannot do\n";
+            return EXIT_FAILURE;
         }
-        return IORequest{};  // Return an empty request if there's already an active request
-    }
-
-    bool hasRequests() const override {
-        return !requestList.empty() || currentActive;
-    }
-
-    bool isActive() const override {
-        return currentActive;
-    }
-
-    int getActiveTrack() const override {
-        if (currentActive) {
-            return activeRequest.track;
+        if (!arrays.empty()) {
+            arrays[0]->streamCompletions(emit);
+        } else {
+            simulators[0]->streamCompletions(emit);
         }
-        return -1;
-    }
-
-    bool isComplete(int currentTime) const override {
-        return currentActive && (currentHeadPosition == activeRequest.track);
     }
 
-    void completeCurrentRequest() override {
-        if (currentActive) {
-            activeRequest.endTime = currentTime;
-            completedRequests.push_back(activeRequest);
-            currentActive = false;
+    // Comparison mode and anticipation replay the trace more than once, so
+    // it is parsed once into memory
+    std::vector<IORequest> requests;
+    if (simulators.size() > 1 || tuning.anticipation > 0) {
+        IORequest req;
+        while (trace->next(req)) {
+            requests.push_back(req);
         }
-    }
-
-    void startNextRequest() override {
-        if (!currentActive && !requestList.empty()) {
-            getNextRequest();
+        trace = std::make_unique<VectorTraceSource>(requests);
+    }
+
+    // Checkpoints: a snapshot every checkpointInterval time units, which a
+    // later run resumes from by skipping the requests it had admitted. A
+    // snapshot grows with the pending requests, so under overload one is
+    // skipped while the previous took more than 1% of the time since.
+    auto lastCheckpoint = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::duration checkpointCost{};
+    auto saveCheckpoint = [&]() {
+        auto start = std::chrono::steady_clock::now();
+        if (start - lastCheckpoint < 99 * checkpointCost) {
+            return;
+        }
+        SnapshotWriter out;
+        out.put(deviceCount);
+        if (!arrays.empty()) {
+            arrays[0]->save(out);
+        } else {
+            simulators[0]->save(out);
+        }
+        if (!writeSnapshot(checkpointName, out)) {
+            std::cerr << "Error writing checkpoint: " << checkpointName << std::endl;
+        }
+        lastCheckpoint = std::chrono::steady_clock::now();
+        checkpointCost = lastCheckpoint - start;
+    };
+    if (!resumeName.empty()) {
+        std::string bytes;
+        bool restored = readSnapshot(resumeName, bytes);
+        SnapshotReader in(bytes);
+        restored = restored && in.get<int>() == deviceCount &&
+                   (arrays.empty() ? simulators[0]->restore(in) : arrays[0]->restore(in)) && in.atEnd();
+        if (!restored) {
+            std::cerr << "Invalid checkpoint for these options: " << resumeName << "\n";
+            return EXIT_FAILURE;
         }
-    }
-
-    const std::vector<IORequest>& getCompletedRequests() const override {
-        return completedRequests;
-    }
-};
-
-// Comparator class to manage comparison of IORequest based on track proximity
-class TrackComparator {
-public:
-    int headPosition;
-    int direction;
-
-    TrackComparator(int headPos, int dir) : headPosition(headPos), direction(dir) {}
-
-    bool operator()(const IORequest& lhs, const IORequest& rhs) {
-        // Compare based on proximity to the current head position
-        int distL = std::abs(lhs.track - headPosition);
-        int distR = std::abs(rhs.track - headPosition);
-
-        // If both requests are in the same direction as the head is moving
-        if ((direction == 1 && lhs.track >= headPosition && rhs.track >= headPosition) ||
-            (direction == -1 && lhs.track <= headPosition && rhs.track <= headPosition)) {
-            return distL < distR; // The one closer to the head comes first
+        long long admitted = arrays.empty() ? simulators[0]->admittedCount() : arrays[0]->admittedCount();
+        if (trace->skip(admitted) != admitted) {
+            std::cerr << "The trace is shorter than the checkpoint: " << resumeName << "\n";
+            return EXIT_FAILURE;
         }
-        return lhs.track < rhs.track; // If equal, sort by track number
-    }
-};
-
-// FLOOK scheduling algorithm implementation
-class FLOOK : public IOScheduler {
-private:
-    std::list<IORequest> activeQueue; // Queue currently being serviced
-    std::list<IORequest> incomingQueue; // Queue for incoming requests
-    IORequest activeRequest;
-    bool currentActive = false;
-    std::vector<IORequest> completedRequests;
-    int direction = 1; // 1 for increasing track numbers, -1 for decreasing
-
-public:
-    void addRequest(IORequest req) override {
-        incomingQueue.push_back(req);
-    }
-
-    IORequest getNextRequest() override {
-        if (!currentActive) {
-            if (activeQueue.empty()) {
-                std::swap(activeQueue, incomingQueue);
-                activeQueue.sort(TrackComparator(currentHeadPosition, direction));
-            }
-
-            auto it = findNextRequest();
-            if (it != activeQueue.end()) {
-                activeRequest = *it;
-                activeQueue.erase(it);
-                activeRequest.startTime = currentTime;
-                currentActive = true;
-                return activeRequest;
-            }
+        if (liveInterval > 0) {
+            int64_t now = arrays.empty() ? simulators[0]->state().currentTime : arrays[0]->device(0).state().currentTime;
+            nextReport = (now / liveInterval + 1) * static_cast<long long>(liveInterval);
         }
-        return IORequest{}; // Return an empty request if no appropriate one is found
     }
-
-    std::list<IORequest>::iterator findNextRequest() {
-        auto selected = activeQueue.end();
-        int distance = INT_MAX;
-
-        for (auto it = activeQueue.begin(); it != activeQueue.end(); ++it) {
-            int dist = std::abs(it->track - currentHeadPosition);
-            if ((direction == 1 && it->track >= currentHeadPosition) || (direction == -1 && it->track <= currentHeadPosition)) {
-                if (dist < distance) {
-                    distance = dist;
-                    selected = it;
-                }
-            }
-        }
-
-        // If no request found in the current direction, change direction
-        if (selected == activeQueue.end()) {
-            direction *= -1; // Reverse the direction
-            return findNextRequest(); // Recursive call to find in the new direction
+    if (!checkpointName.empty()) {
+        if (!arrays.empty()) {
+            arrays[0]->checkpointEvery(checkpointInterval, saveCheckpoint);
+        } else {
+            simulators[0]->checkpointEvery(checkpointInterval, saveCheckpoint);
         }
-
-        return selected;
-    }
-
-    bool hasRequests() const override {
-        return !activeQueue.empty() || !incomingQueue.empty() || currentActive;
     }
 
-    bool isActive() const override {
-        return currentActive;
-    }
-
-    int getActiveTrack() const override {
-        if (currentActive) {
-            return activeRequest.track;
+    // "ANTIC: windows=.. hits=.. idle=.. saved=..", where saved is the head
+    // movement of the same algorithm without anticipation minus this run's
+    auto printAnticipation = [&](size_t i, const std::string& prefix) {
+        SchedulerTuning plain = tuning;
+        plain.anticipation = 0;
+        VectorTraceSource replay(requests);
+        long long baseline;
+        if (arrays.empty()) {
+            auto sim = Simulator::create(schedulerTypes[i], cost, plain);
+            sim->run(replay);
+            baseline = sim->state().totalMovement;
+        } else {
+            auto array = DiskArray::create(schedulerTypes[i], deviceCount, placement, cost, plain);
+            array->run(replay);
+            baseline = array->statistics().total_movement;
         }
-        return -1;
-    }
+        AnticipationStats antic = arrays.empty() ? simulators[i]->anticipation() : arrays[i]->anticipation();
+        long long movement = arrays.empty() ? simulators[i]->state().totalMovement : arrays[i]->statistics().total_movement;
+        std::cout << prefix << "ANTIC: windows=" << antic.windows << " hits=" << antic.hits << " idle=" << antic.idleTime
+                  << " saved=" << baseline - movement << "\n";
+    };
 
-    bool isComplete(int currentTime) const override {
-        return currentActive && (currentHeadPosition == activeRequest.track);
-    }
+    if (simulators.size() == 1) {
+        if (!arrays.empty()) {
+            arrays[0]->run(*trace);
+            arrays[0]->printStatistics();
+        } else {
+            simulators[0]->run(*trace);
 
-    void completeCurrentRequest() override {
-        if (currentActive) {
-            activeRequest.endTime = currentTime;
-            completedRequests.push_back(activeRequest);
-            currentActive = false;
+            // Print final statistics here
+            simulators[0]->printStatistics();
         }
-    }
-
-    void startNextRequest() override {
-        if (!currentActive && (!activeQueue.empty() || !incomingQueue.empty())) {
-            getNextRequest();
+        if (tuning.coalesce) {
+            std::cout << "MERGED: " << mergesOf(0) << "\n";
         }
-    }
-
-    const std::vector<IORequest>& getCompletedRequests() const override {
-        return completedRequests;
-    }
-};
-
-// Function to read IO requests from file
-std::vector<IORequest> readRequests(const std::string& filename) {
-    std::vector<IORequest> requests;
-    std::ifstream file(filename);
-    if (!file) {
-        std::cerr << "Error opening file: " << filename << std::endl;
-        return requests;
-    }
-
-    std::string line;
-    int requestId = 0; // Start an ID counter for each request
-    while (std::getline(file, line)) {
-        if (line.empty() || line[0] == '#') continue; // Skip empty lines and comments
-        std::istringstream iss(line);
-        IORequest req;
-        if (iss >> req.arrivalTime >> req.track) {
-            req.id = requestId++; // Assign an incrementing ID to each request
-            // Initialize startTime and endTime with default values if needed
-            req.startTime = 0; // This will be set when the request is processed
-            req.endTime = 0;   // This will be set when the request completes
-            requests.push_back(req);
+        if (tuning.anticipation > 0) {
+            printAnticipation(0, "");
         }
-    }
-    return requests;
-}
-
-// Function to print IO requests
-void printRequests(const std::vector<IORequest>& requests) {
-    std::cout << "Total IO Requests: " << requests.size() << std::endl;
-    for (const auto& req : requests) {
-        std::cout << "Arrival Time: " << req.arrivalTime << ", Track: " << req.track << std::endl;
-    }
-}
-void printStatistics(const std::vector<IORequest>& completedRequests) {
-    // First, sort the requests by ID
-    std::vector<IORequest> sortedRequests = completedRequests; // Make a copy to sort
-    std::sort(sortedRequests.begin(), sortedRequests.end(), [](const IORequest& a, const IORequest& b) {
-        return a.id < b.id; // Sorting criterion
-    });
-
-    // Now print each request in order of their ID
-    for (const auto& req : sortedRequests) {
-        std::cout << std::right << std::setw(5) << req.id << ":"
-                  << std::setw(6) << req.arrivalTime
-                  << std::setw(6) << req.startTime
-                  << std::setw(6) << req.endTime << std::endl;
-    }
-
-    if (!completedRequests.empty()) {
-        int total_time = completedRequests.back().endTime;
-        int total_movement = totalTrack;
-        // for (size_t i = 1; i < completedRequests.size(); ++i) {
-        //     total_movement += std::abs(completedRequests[i].track - completedRequests[i - 1].track);
-        // }
-        double io_utilization = (double)total_movement / (currentTime - 1);
-        double total_turnaround_time = 0;
-        for (const auto& req : completedRequests) {
-            total_turnaround_time += req.endTime - req.arrivalTime;
-        }
-        double avg_turnaround = total_turnaround_time / completedRequests.size();
-
-        // Calculate average wait time
-        double total_wait_time = 0;
-        for (const auto& req : completedRequests) {
-            total_wait_time += req.startTime - req.arrivalTime;
+        if (tuning.queueDepth > 1) {
+            printQueueWaits(std::cout, tuning.queueDepth, waitsOf(0));
         }
-        double avg_waittime = total_wait_time / completedRequests.size();
-
-        int max_waittime = 0;
-        for (const auto& req : completedRequests) {
-            int waitTime = req.startTime - req.arrivalTime;
-            if (waitTime > max_waittime) {
-                max_waittime = waitTime;
-            }
+        if (printLatency) {
+            printPercentiles(std::cout, latencyOf(0));
         }
-
-        std::cout << "SUM: " << total_time << " " << total_movement << " " << std::fixed << std::setprecision(4) << io_utilization << " "
-                  << std::fixed << std::setprecision(2) << avg_turnaround << " " << avg_waittime << " " << max_waittime <<"\n";
-    }
-}
-
-// Main function that sets up and runs the simulation
-int main(int argc, char* argv[]) {
-    std::string inputFileName;
-    char schedulerType = 'N';  // Default scheduler type set to 'N' for FIFO
-    int opt;
-
-    while ((opt = getopt(argc, argv, "s:")) != -1) {
-        switch (opt) {
-            case 's':
-                schedulerType = optarg[0];
-                break;
-            default:
-                std::cerr << "Usage: " << argv[0] << " -s <schedalgo> <inputfile>\n";
-                return EXIT_FAILURE;
+        if (histogramFile.is_open()) {
+            writeLatencyJson(histogramFile, schedulerTypes[0], latencyOf(0));
         }
+        printProfile();
+        return 0;
     }
 
-    // The input file should be the next argument after the options
-    if (optind < argc) {
-        inputFileName = argv[optind];
-    } else {
-        std::cerr << "Expected input file\n";
-        return EXIT_FAILURE;
-    }
-
-    auto requests = readRequests(inputFileName);
-    std::unique_ptr<IOScheduler> scheduler;
-
-    // Instantiate the appropriate scheduler
-    switch (schedulerType) {
-        case 'N':
-            scheduler.reset(new FIFO());
-            break;
-        case 'S':
-            scheduler.reset(new SSTF());
-            break;
-        case 'L':
-            scheduler.reset(new LOOK());
-            break;
-        case 'C':
-            scheduler.reset(new CLOOK());
-            break;
-        case 'F':
-            scheduler.reset(new FLOOK());
-            break;
-        default:
-            std::cerr << "Invalid scheduler type specified: " << schedulerType << "\n";
-            return EXIT_FAILURE;
-    }
-    size_t requestIndex = 0;
-    bool allRequestsProcessed = false;
-
-    // Print requests to check input parsing
-    // printRequests(requests);
-    
-    while (!allRequestsProcessed) {
-        int isMoveHead = 0;
-        int edgeFlag = 1;
-        
-        // Process any new arrivals at the current time
-        if (requests[requestIndex].arrivalTime == currentTime) {
-            scheduler->addRequest(requests[requestIndex]);
-            requestIndex++;
+    // Comparison mode: replay the trace through every selected simulator
+    // concurrently, one simulation per worker at a time
+    parallelFor(simulators.size(), [&](size_t i) {
+        VectorTraceSource replay(requests);
+        if (!arrays.empty()) {
+            arrays[i]->run(replay);
+        } else {
+            simulators[i]->run(replay);
         }
+    });
 
-        // Check if the current IO operation is complete
-        if (scheduler->isActive()) { //
-            if (scheduler->isComplete(currentTime)) {
-                scheduler->completeCurrentRequest();
-            } 
+    for (size_t i = 0; i < simulators.size(); i++) {
+        std::cout << schedulerTypes[i] << " ";
+        printSummary(std::cout, arrays.empty() ? simulators[i]->statistics() : arrays[i]->statistics());
+        if (tuning.coalesce) {
+            std::cout << schedulerTypes[i] << " MERGED: " << mergesOf(i) << "\n";
         }
-
-        // If no IO request is active and there are pending requests, start a new IO operation
-        if (!scheduler->isActive() && scheduler->hasRequests()) {
-            scheduler->startNextRequest();
-            isMoveHead = 1;
+        if (tuning.anticipation > 0) {
+            printAnticipation(i, std::string(1, schedulerTypes[i]) + " ");
         }
-
-        // Check if all requests are processed
-        if (!scheduler->hasRequests() && requestIndex >= requests.size()) {
-            allRequestsProcessed = true;
+        if (tuning.queueDepth > 1) {
+            std::cout << schedulerTypes[i] << " ";
+            printQueueWaits(std::cout, tuning.queueDepth, waitsOf(i));
         }
-
-        if (scheduler->isActive()){
-            int activeTrack = scheduler->getActiveTrack();
-            if(currentHeadPosition != activeTrack){
-                if (currentHeadPosition < activeTrack) direction = 1;
-                else if (currentHeadPosition > activeTrack) direction = -1;
-                isMoveHead = 1;
-            }
-            else{
-                direction = 0;
-                edgeFlag = 0;
-            } 
+        if (printLatency) {
+            printPercentiles(std::cout, latencyOf(i), std::string(1, schedulerTypes[i]) + " ");
         }
-        if (edgeFlag){
-            currentTime++;  // Increment the simulation time
+        if (histogramFile.is_open()) {
+            writeLatencyJson(histogramFile, schedulerTypes[i], latencyOf(i));
         }
-        else totalTrack--;
-
-        if (isMoveHead){
-            totalTrack++;
-            currentHeadPosition += direction*1;
-            // total_movement++;
-        } 
     }
-
-    // Print final statistics here
-    printStatistics(scheduler->getCompletedRequests());
-
+    printProfile();
     return 0;
 }
@@ -0,0 +1,2225 @@
+#ifndef IOSCHED_H
+#define IOSCHED_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <queue>
+#include <deque>
+#include <memory>
+#include <iomanip>
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <span>
+#include <functional>
+#include <climits>
+#include <cstdlib>
+#include <cstdint>
+
+#include "cost.h"
+#include "histogram.h"
+#include "nearest.h"
+#include "snapshot.h"
+#include "profile.h"
+
+// Define an IO request struct
+struct IORequest {
+    int id; // Unique identifier for the request
+    int64_t arrivalTime;
+    int track;
+    int64_t startTime; // When the request actually starts processing
+    int64_t endTime;   // When the request completesx
+
+    // Members in snapshot order; see snapshot.h
+    auto fields() { return std::tie(id, arrivalTime, track, startTime, endTime); }
+};
+
+// Clock and head of one simulation. The simulator owns it and advances it;
+// schedulers only read it. Times and totals are 64-bit: with a realistic
+// cost model a long trace runs well past INT_MAX time units.
+struct DiskState {
+    int64_t currentTime = 0;
+    int headPosition = 0;
+    int direction = 1;         // Direction of the last head movement: 1 up, -1 down, 0 stationary
+    int64_t totalMovement = 0; // Tracks traversed by the requests dispatched so far
+    int64_t busyTime = 0;      // Time spent servicing requests so far
+};
+
+// Tunables of the schedulers that have any, and of the queueing in front of them
+struct SchedulerTuning {
+    int deadline = 0;      // DEADLINE: wait after which a request is served ahead of the sweep; 0 for two full strokes
+    int fifoBatch = 16;    // DEADLINE: dispatches per sorted batch between expiry checks
+    bool coalesce = false; // Merge arrivals into a pending request on the same or an adjacent track
+    int anticipation = 0;       // ANTICIPATORY: longest idle window after a completion; 0 disables it
+    int anticipationTracks = 8; // ANTICIPATORY: how close a follow-up must be to end the window
+    int queueDepth = 1;         // Commands the device accepts at once and reorders itself (NCQ)
+};
+
+// Storage for every request of a run, indexed by id. Scheduler queues hold
+// only ids and read the requests from here. Completed requests are written
+// back in place, so they can be listed in id order without sorting. Slots
+// come in pages of 64Ki, so the pool grows without moving or copying the
+// requests it already holds. A page is allocated by the first store into
+// it, so sparse ids cost only their own pages; the page table itself holds
+// at most 32Ki entries for non-negative int ids. A page whose requests have
+// all been released is freed.
+class RequestPool {
+private:
+    static constexpr int pageBits = 16;
+    static constexpr size_t pageSize = size_t(1) << pageBits;
+
+    struct Page {
+        std::unique_ptr<IORequest[]> requests; // Null until the first store, and once freed
+        std::unique_ptr<uint8_t[]> done;
+        size_t released = 0;
+    };
+    std::vector<Page> pages;
+
+    // Allocate the page for an id on its first store
+    bool allocate(int id) {
+        if (!canStore(id)) {
+            return false;
+        }
+        size_t page = static_cast<size_t>(id) >> pageBits;
+        if (pages.size() <= page) {
+            pages.resize(page + 1);
+        }
+        pages[page].requests.reset(new IORequest[pageSize]);
+        pages[page].done.reset(new uint8_t[pageSize]());
+        return true;
+    }
+
+public:
+    // Store a request in the slot for its id. Returns false, and stores
+    // nothing, for an id that cannot be a slot (see canStore).
+    bool store(const IORequest& req) {
+        size_t page = static_cast<size_t>(req.id) >> pageBits;
+        if ((page >= pages.size() || !pages[page].requests) && !allocate(req.id)) {
+            return false;
+        }
+        pages[page].requests[req.id & (pageSize - 1)] = req;
+        return true;
+    }
+
+    const IORequest& operator[](int id) const {
+        return pages[static_cast<size_t>(id) >> pageBits].requests[id & (pageSize - 1)];
+    }
+
+    // The slot for an id exists or can be added; false for a negative id
+    // and once its page was freed
+    bool canStore(int id) const {
+        size_t page = static_cast<size_t>(id) >> pageBits;
+        return id >= 0 && (page >= pages.size() || pages[page].released < pageSize);
+    }
+
+    IORequest& operator[](int id) {
+        return pages[static_cast<size_t>(id) >> pageBits].requests[id & (pageSize - 1)];
+    }
+
+    // Write back a finished request and mark it completed. Returns false,
+    // like store(), for an id that cannot be a slot.
+    bool complete(const IORequest& req) {
+        if (!store(req)) {
+            return false;
+        }
+        pages[static_cast<size_t>(req.id) >> pageBits].done[req.id & (pageSize - 1)] = 1;
+        return true;
+    }
+
+    // Drop a completed request that is no longer needed; it is not visited
+    // by forEachCompleted() again
+    void release(int id) {
+        size_t index = static_cast<size_t>(id) >> pageBits;
+        if (id < 0 || index >= pages.size() || !pages[index].done) {
+            return;
+        }
+        Page& page = pages[index];
+        page.done[id & (pageSize - 1)] = 0;
+        if (++page.released == pageSize) {
+            page.requests.reset();
+            page.done.reset();
+        }
+    }
+
+    // Checkpointing: how many requests were released from each page that
+    // has any, so pages freed before the snapshot stay freed. The requests
+    // themselves are written by whoever holds them, and completed ones are
+    // not kept; restoring them allocates their pages again.
+    struct Released {
+        uint64_t page;
+        uint64_t count;
+    };
+
+    void save(SnapshotWriter& out) const {
+        std::vector<Released> released;
+        for (size_t i = 0; i < pages.size(); i++) {
+            if (pages[i].released > 0) released.push_back({i, pages[i].released});
+        }
+        out.putVector(released);
+    }
+
+    void restore(SnapshotReader& in) {
+        pages.clear();
+        std::vector<Released> released;
+        in.getVector(released);
+        for (const auto& entry : released) {
+            size_t maxPages = (static_cast<size_t>(INT_MAX) >> pageBits) + 1;
+            if (entry.page >= maxPages || entry.page < pages.size() || entry.count > pageSize) {
+                in.fail();
+                return;
+            }
+            pages.resize(entry.page + 1);
+            pages[entry.page].released = entry.count;
+        }
+    }
+
+    // Visit the completed requests in id order
+    template <typename F>
+    void forEachCompleted(F&& f) const {
+        for (const auto& page : pages) {
+            if (!page.done) continue;
+            for (size_t i = 0; i < pageSize; i++) {
+                if (page.done[i]) f(page.requests[i]);
+            }
+        }
+    }
+};
+
+// Abstract class for IO Scheduling Algorithms
+class IOScheduler {
+protected:
+    const DiskState& disk; // State of the simulation this scheduler belongs to
+    const CostModel& cost; // Service time model of that disk
+    RequestPool& pool;     // Where pending requests live and completed ones are written back
+
+public:
+    IOScheduler(const DiskState& diskState, const CostModel& costModel, RequestPool& requestPool)
+        : disk(diskState), cost(costModel), pool(requestPool) {}
+
+    // Virtual destructor for safe polymorphic deletion
+    virtual ~IOScheduler() {}
+
+    // Add a request to the scheduler
+    virtual void addRequest(IORequest req) = 0;
+
+    // Add a batch of requests, in arrival order
+    virtual void addRequests(std::span<const IORequest> reqs) {
+        for (const auto& req : reqs) {
+            addRequest(req);
+        }
+    }
+
+    // Get the next request, potentially activating it
+    virtual IORequest getNextRequest() = 0;
+
+    // Check if the scheduler has pending requests
+    virtual bool hasRequests() const = 0;
+
+    // Check if there is currently an active I/O operation
+    virtual bool isActive() const = 0;
+
+    virtual int getActiveTrack() const  = 0;
+
+    virtual bool isComplete(int64_t currentTime) const = 0;
+
+    // Marks the current active request as completed
+    virtual void completeCurrentRequest() = 0;
+
+    // While the scheduler deliberately leaves the disk idle with requests
+    // pending, the time at which it will dispatch anyway; INT64_MAX otherwise
+    virtual int64_t wakeTime() const { return INT64_MAX; }
+
+    // Method to simulate the movement of the disk head
+    // virtual void moveHead() = 0;
+
+    virtual void startNextRequest() = 0;
+
+    // Checkpointing: write the pending requests and any private state, and
+    // read them back into a scheduler freshly created with the same options
+    virtual void save(SnapshotWriter& out) const = 0;
+    virtual void restore(SnapshotReader& in) = 0;
+};
+
+// A request read back from a snapshot and stored in the pool. Returns false,
+// and fails the reader, on a truncated snapshot or an id that cannot be a
+// pool slot.
+inline bool restoreRequest(SnapshotReader& in, RequestPool& pool, IORequest& req) {
+    in.get(req);
+    if (!pool.canStore(req.id)) {
+        in.fail();
+    }
+    if (!in.ok()) {
+        return false;
+    }
+    pool.store(req);
+    return true;
+}
+
+// Track-ordered index of pending requests shared by the SSTF and LOOK
+// families. The requests themselves are kept in the pool; the index holds
+// (track, id) pairs, so requests on the same track keep their arrival order.
+//
+// Small queues are stored flat, as unordered int32 arrays of tracks and
+// ids, and searched with the SIMD kernel in nearest.h. A linear scan over a
+// few hundred entries beats chasing tree nodes, and insert and take are
+// O(1). Past flatLimit entries the index moves to a balanced tree where
+// every lookup is O(log n), and it moves back once it has drained to a
+// quarter of that. Both forms pick the same request for every lookup.
+class TrackIndex {
+private:
+    // Plain (track, id) order; every comparison made by a selection counts
+    // as one node visited
+    struct TrackOrder {
+        bool operator()(const std::pair<int, int>& a, const std::pair<int, int>& b) const {
+            PROFILE_VISIT(1, 1);
+            return a < b;
+        }
+    };
+    using Tree = std::set<std::pair<int, int>, TrackOrder>;
+
+    static constexpr size_t flatLimit = 192;
+
+    RequestPool& pool;
+    bool flat = true;
+    std::vector<int> tracks; // Flat form, in no particular order
+    std::vector<int> ids;
+    Tree tree;               // Tree form
+    Tree::const_iterator afterTake; // Tree form: entry after the last one taken
+    int takenTrack = 0;      // Track of the last entry taken
+    bool resumable = false;  // Nothing has been inserted since that take
+
+public:
+    // A request found by a lookup. Valid until the index is next changed.
+    struct Entry {
+        int track = 0;
+        int id = -1;         // -1 when the lookup found nothing
+        size_t slot = 0;     // Position in the flat arrays
+        Tree::const_iterator node; // Position in the tree
+
+        bool found() const { return id >= 0; }
+    };
+
+private:
+    Entry flatEntry(size_t slot) const {
+        if (slot >= tracks.size()) return Entry{};
+        return Entry{tracks[slot], ids[slot], slot, {}};
+    }
+
+    Entry treeEntry(Tree::const_iterator it) const {
+        if (it == tree.end()) return Entry{};
+        return Entry{it->first, it->second, 0, it};
+    }
+
+    void toTree() {
+        for (size_t i = 0; i < tracks.size(); i++) {
+            tree.emplace(tracks[i], ids[i]);
+        }
+        tracks.clear();
+        ids.clear();
+        flat = false;
+    }
+
+    void toFlat() {
+        for (const auto& [track, id] : tree) {
+            tracks.push_back(track);
+            ids.push_back(id);
+        }
+        tree.clear();
+        flat = true;
+    }
+
+public:
+    explicit TrackIndex(RequestPool& requestPool) : pool(requestPool) {}
+
+    void insert(const IORequest& req) {
+        pool.store(req);
+        resumable = false;
+        if (!flat) {
+            tree.emplace(req.track, req.id);
+            return;
+        }
+        tracks.push_back(req.track);
+        ids.push_back(req.id);
+        if (tracks.size() > flatLimit) toTree();
+    }
+
+    // Remove a request from the index and hand it back
+    IORequest take(const Entry& entry) {
+        IORequest req = pool[entry.id];
+        if (flat) {
+            tracks[entry.slot] = tracks.back();
+            ids[entry.slot] = ids.back();
+            tracks.pop_back();
+            ids.pop_back();
+        } else {
+            afterTake = tree.erase(entry.node);
+            if (tree.size() <= flatLimit / 4) toFlat();
+        }
+        takenTrack = req.track;
+        resumable = true;
+        return req;
+    }
+
+    bool empty() const { return flat ? tracks.empty() : tree.empty(); }
+    size_t size() const { return flat ? tracks.size() : tree.size(); }
+
+    // Earliest-arrived request on the lowest track at or above the given track
+    Entry atOrAbove(int track) const {
+        PROFILE_VISIT(flat ? tracks.size() : 0, flat ? tracks.size() : 0);
+        if (flat) return flatEntry(nearest::find<nearest::Side::Up>(tracks.data(), ids.data(), tracks.size(), track));
+        return treeEntry(tree.lower_bound({track, INT_MIN}));
+    }
+
+    // Earliest-arrived request on the highest track at or below the given track
+    Entry atOrBelow(int track) const {
+        PROFILE_VISIT(flat ? tracks.size() : 0, flat ? tracks.size() : 0);
+        if (flat) return flatEntry(nearest::find<nearest::Side::Down>(tracks.data(), ids.data(), tracks.size(), track));
+        auto it = tree.upper_bound({track, INT_MAX});
+        if (it == tree.begin()) {
+            return Entry{};
+        }
+        PROFILE_VISIT(0, 1);
+        return treeEntry(tree.lower_bound({std::prev(it)->first, INT_MIN}));
+    }
+
+    // Closest request in the given direction (1 up, -1 down)
+    Entry nearest(int track, int dir) const {
+        return dir == 1 ? atOrAbove(track) : atOrBelow(track);
+    }
+
+    // The same as nearest(), for a sweep that has just taken the request its
+    // last lookup from this track returned. The tree form steps on from that
+    // request instead of searching again; going down it walks back over the
+    // next track's requests once, so a sweep costs O(1) per request amortized.
+    Entry nextFrom(int track, int dir) const {
+        if (flat || !resumable || track != takenTrack) return nearest(track, dir);
+        PROFILE_VISIT(1, 1);
+        auto it = afterTake;
+        if (dir == 1 || (it != tree.end() && it->first == track)) return treeEntry(it);
+        if (it == tree.begin()) return Entry{};
+        int below = std::prev(it)->first;
+        for (--it; it != tree.begin() && std::prev(it)->first == below; --it) {
+            PROFILE_VISIT(1, 1);
+        }
+        return treeEntry(it);
+    }
+
+    // Closest request on either side; on equal distance the earlier arrival wins
+    Entry closest(int track) const {
+        PROFILE_VISIT(flat ? tracks.size() : 0, flat ? tracks.size() : 0);
+        if (flat) return flatEntry(nearest::find<nearest::Side::Either>(tracks.data(), ids.data(), tracks.size(), track));
+        Entry above = atOrAbove(track);
+        Entry below = atOrBelow(track);
+        if (!above.found()) return below;
+        if (!below.found()) return above;
+        int distAbove = above.track - track;
+        int distBelow = track - below.track;
+        if (distBelow < distAbove || (distBelow == distAbove && below.id < above.id)) {
+            return below;
+        }
+        return above;
+    }
+
+    // Earliest-arrived request on the lowest track
+    Entry lowest() const {
+        return atOrAbove(INT_MIN);
+    }
+
+    Entry find(const IORequest& req) const {
+        if (flat) {
+            size_t slot = std::find(ids.begin(), ids.end(), req.id) - ids.begin();
+            PROFILE_VISIT(std::min(slot + 1, ids.size()), std::min(slot + 1, ids.size()));
+            return flatEntry(slot);
+        }
+        return treeEntry(tree.find({req.track, req.id}));
+    }
+
+    // Visit the entries outwards from the given track, up first and then
+    // down. In tree form a side is abandoned as soon as `visit` returns
+    // false; the flat form has no order and visits every entry.
+    template <typename F>
+    void walkOutward(int track, F&& visit) const {
+        if (flat) {
+            for (size_t i = 0; i < tracks.size(); i++) {
+                visit(flatEntry(i));
+            }
+            return;
+        }
+        auto above = tree.lower_bound({track, INT_MIN});
+        for (auto it = above; it != tree.end() && visit(treeEntry(it)); ++it) {
+        }
+        for (auto it = above; it != tree.begin();) {
+            --it;
+            if (!visit(treeEntry(it))) break;
+        }
+    }
+
+    // Checkpointing. Entries are written as the full requests, since the
+    // pool is not part of the snapshot, and go back in through insert(),
+    // which picks the form by size; both forms answer alike.
+    void save(SnapshotWriter& out) const {
+        out.put<uint64_t>(size());
+        if (flat) {
+            for (int id : ids) out.put(pool[id]);
+        } else {
+            for (const auto& entry : tree) out.put(pool[entry.second]);
+        }
+    }
+
+    // Restore the entries, calling `restored` with each one
+    template <typename F>
+    void restore(SnapshotReader& in, F&& restored) {
+        size_t count = in.getCount(snapshotSize<IORequest>());
+        IORequest req;
+        for (size_t i = 0; i < count && restoreRequest(in, pool, req); i++) {
+            insert(req);
+            restored(req);
+        }
+    }
+
+    void restore(SnapshotReader& in) {
+        restore(in, [](const IORequest&) {});
+    }
+
+    void swap(TrackIndex& other) {
+        std::swap(flat, other.flat);
+        tracks.swap(other.tracks);
+        ids.swap(other.ids);
+        tree.swap(other.tree);
+        resumable = other.resumable = false;
+    }
+};
+
+// FIFO scheduling algorithm implementation
+class FIFO final : public IOScheduler {
+private:
+    std::deque<int> requestQueue;           // Ids of the incoming requests, in arrival order
+    bool currentActive = false;             // Flag to check if a request is currently being processed
+    IORequest activeRequest;                // The request currently being processed
+
+public:
+    using IOScheduler::IOScheduler;
+
+    void addRequest(IORequest req) override {
+        pool.store(req);
+        requestQueue.push_back(req.id);
+    }
+
+    void addRequests(std::span<const IORequest> reqs) override {
+        for (const auto& req : reqs) {
+            pool.store(req);
+            requestQueue.push_back(req.id);
+        }
+    }
+
+    IORequest getNextRequest() override {
+        if (!requestQueue.empty() && !currentActive) {  // Only fetch next request if no active request
+            PROFILE_PHASE(Select);
+            PROFILE_VISIT(0, 1);
+            activeRequest = pool[requestQueue.front()];
+            requestQueue.pop_front();
+            activeRequest.startTime = disk.currentTime;
+            currentActive = true;
+            return activeRequest;
+        }
+        return IORequest{}; // Return an empty request if one is active
+    }
+
+    bool hasRequests() const override {
+        return !requestQueue.empty() || currentActive;
+    }
+
+    bool isActive() const override {
+        return currentActive;
+    }
+
+    int getActiveTrack() const {
+        if (currentActive) {
+            return activeRequest.track;
+        }
+        return -1; // Return an invalid track number if no active request
+    }
+
+    bool isComplete(int64_t currentTime) const override {
+        return currentActive && (disk.headPosition == activeRequest.track); 
+    }
+
+    void completeCurrentRequest() override {
+        if (currentActive) {
+            activeRequest.endTime = disk.currentTime;
+            pool.complete(activeRequest);
+            currentActive = false;
+        }
+    }
+
+    void startNextRequest() override {
+        if (!currentActive && !requestQueue.empty()) {
+            getNextRequest();  // Start the next request only if there is no active request
+        }
+    }
+
+    void save(SnapshotWriter& out) const override {
+        out.put(currentActive);
+        out.put(activeRequest);
+        out.put<uint64_t>(requestQueue.size());
+        for (int id : requestQueue) {
+            out.put(pool[id]);
+        }
+    }
+
+    void restore(SnapshotReader& in) override {
+        in.get(currentActive);
+        in.get(activeRequest);
+        size_t count = in.getCount(snapshotSize<IORequest>());
+        IORequest req;
+        for (size_t i = 0; i < count && restoreRequest(in, pool, req); i++) {
+            requestQueue.push_back(req.id);
+        }
+    }
+};
+
+// SSTF scheduling algorithm implementation
+class SSTF final : public IOScheduler {
+private:
+    TrackIndex requestList{pool};           // Track-ordered index of all pending requests
+    bool currentActive = false;       // Flag to check if there is an active request
+    IORequest activeRequest;          // Stores the current active request
+
+public:
+    using IOScheduler::IOScheduler;
+
+    // Adding a new IO request to the pool
+    void addRequest(IORequest req) override {
+        requestList.insert(req);
+    }
+
+    // Fetching the next request based on the shortest seek time
+    IORequest getNextRequest() override {
+        if (!requestList.empty() && !currentActive) {
+            activeRequest = requestList.take(findNextRequest());  // Remove the request from the pool
+            activeRequest.startTime = disk.currentTime;  // Set the start time for the request
+            currentActive = true;
+            return activeRequest;
+        }
+        return IORequest{};  // Return an empty request if there's already an active request
+    }
+
+    // Closest request on either side of the head; on equal distance the
+    // earlier arrival wins
+    TrackIndex::Entry findNextRequest() {
+        PROFILE_PHASE(Select);
+        if (cost.hasRotation()) {
+            return findShortestPositioning();
+        }
+        return requestList.closest(disk.headPosition);
+    }
+
+    // With rotational latency the nearest track is not necessarily the
+    // quickest to reach, so compare full positioning times instead (SPTF).
+    // Seek time grows with distance and positioning time is never below it,
+    // so each side is walked outwards only until the seek alone exceeds the
+    // best time found.
+    TrackIndex::Entry findShortestPositioning() {
+        TrackIndex::Entry best;
+        double bestTime = 0;
+        requestList.walkOutward(disk.headPosition, [&](const TrackIndex::Entry& e) {
+            PROFILE_VISIT(1, 1);
+            if (best.found() && cost.seekTime(std::abs(static_cast<int64_t>(e.track) - disk.headPosition)) > bestTime) {
+                return false;
+            }
+            double time = cost.positioningTime(disk.headPosition, e.track, e.id, disk.currentTime);
+            if (!best.found() || time < bestTime || (time == bestTime && e.id < best.id)) {
+                best = e;
+                bestTime = time;
+            }
+            return true;
+        });
+        return best;
+    }
+
+    // Check if there are pending requests or an active request
+    bool hasRequests() const override {
+        return !requestList.empty() || currentActive;
+    }
+
+    // Check if there's an active request
+    bool isActive() const override {
+        return currentActive;
+    }
+
+    // Retrieve the track of the active request
+    int getActiveTrack() const override {
+        if (currentActive) {
+            return activeRequest.track;
+        }
+        return -1;
+    }
+
+    // Determine if the current request has completed
+    bool isComplete(int64_t currentTime) const override {
+        return currentActive && (disk.headPosition == activeRequest.track);
+    }
+
+    // Mark the current request as completed
+    void completeCurrentRequest() override {
+        if (currentActive) {
+            activeRequest.endTime = disk.currentTime;
+            pool.complete(activeRequest);
+            currentActive = false;
+        }
+    }
+
+    // Attempt to start the next request if no current active request
+    void startNextRequest() override {
+        if (!currentActive && !requestList.empty()) {
+            getNextRequest();
+        }
+    }
+
+    void save(SnapshotWriter& out) const override {
+        out.put(currentActive);
+        out.put(activeRequest);
+        requestList.save(out);
+    }
+
+    void restore(SnapshotReader& in) override {
+        in.get(currentActive);
+        in.get(activeRequest);
+        requestList.restore(in);
+    }
+};
+
+// LOOK scheduling algorithm implementation
+class LOOK final : public IOScheduler {
+private:
+    TrackIndex requests{pool}; // Track-ordered index of all pending requests
+    bool currentActive = false;
+    IORequest activeRequest;
+    int direction = 1; // 1 for increasing track numbers, -1 for decreasing
+
+public:
+    using IOScheduler::IOScheduler;
+
+    // Add a new IO request to the pool
+    void addRequest(IORequest req) override {
+        requests.insert(req);
+    }
+
+    // Fetching the next request based on LOOK strategy
+    IORequest getNextRequest() override {
+        if (!requests.empty() && !currentActive) {
+            auto it = findNextRequest();
+            if (it.found()) {
+                activeRequest = requests.take(it);
+                activeRequest.startTime = disk.currentTime;
+                currentActive = true;
+                return activeRequest;
+            }
+        }
+        return IORequest{}; // Return an empty request if no appropriate one is found
+    }
+
+    // Helper function to find the next request in the current direction
+    TrackIndex::Entry findNextRequest() {
+        PROFILE_PHASE(Select);
+        auto selected = requests.nearest(disk.headPosition, direction);
+
+        // If no request found in the current direction, change direction
+        if (!selected.found()) {
+            direction = -direction; // Reverse the direction
+            selected = requests.nearest(disk.headPosition, direction);
+        }
+
+        return selected;
+    }
+
+    // Check if there are pending requests or an active request
+    bool hasRequests() const override {
+        return !requests.empty() || currentActive;
+    }
+
+    // Check if there's an active request
+    bool isActive() const override {
+        return currentActive;
+    }
+
+    // Retrieve the track of the active request
+    int getActiveTrack() const override {
+        if (currentActive) {
+            return activeRequest.track;
+        }
+        return -1;
+    }
+
+    // Determine if the current request has completed
+    bool isComplete(int64_t currentTime) const override {
+        return currentActive && (disk.headPosition == activeRequest.track);
+    }
+
+    // Mark the current request as completed
+    void completeCurrentRequest() override {
+        if (currentActive) {
+            activeRequest.endTime = disk.currentTime;
+            pool.complete(activeRequest);
+            currentActive = false;
+        }
+    }
+
+    // Attempt to start the next request if no current active request
+    void startNextRequest() override {
+        if (!currentActive && !requests.empty()) {
+            getNextRequest();
+        }
+    }
+
+    void save(SnapshotWriter& out) const override {
+        out.put(currentActive);
+        out.put(activeRequest);
+        out.put(direction);
+        requests.save(out);
+    }
+
+    void restore(SnapshotReader& in) override {
+        in.get(currentActive);
+        in.get(activeRequest);
+        in.get(direction);
+        requests.restore(in);
+    }
+};
+
+// CLOOK scheduling algorithm implementation
+class CLOOK final : public IOScheduler {
+private:
+    TrackIndex requestList{pool};           // Track-ordered index of all pending requests
+    bool currentActive = false;       // Flag to check if there is an active request
+    IORequest activeRequest;          // Stores the current active request
+
+public:
+    using IOScheduler::IOScheduler;
+
+    // Adding a new IO request to the pool
+    void addRequest(IORequest req) override {
+        requestList.insert(req);
+    }
+
+    // Fetching the next request based on C-LOOK strategy
+    IORequest getNextRequest() override {
+        if (!requestList.empty() && !currentActive) {
+            activeRequest = requestList.take(findNextRequest());  // Remove the request from the pool
+            activeRequest.startTime = disk.currentTime;  // Set the start time for the request
+            currentActive = true;
+            return activeRequest;
+        }
+        return IORequest{};  // Return an empty request if there's already an active request
+    }
+
+    // Take the closest request at or above the head, wrapping around to the
+    // lowest track when there is none
+    TrackIndex::Entry findNextRequest() {
+        PROFILE_PHASE(Select);
+        auto it = requestList.atOrAbove(disk.headPosition);
+        if (!it.found()) {
+            it = requestList.lowest();
+        }
+        return it;
+    }
+
+    bool hasRequests() const override {
+        return !requestList.empty() || currentActive;
+    }
+
+    bool isActive() const override {
+        return currentActive;
+    }
+
+    int getActiveTrack() const override {
+        if (currentActive) {
+            return activeRequest.track;
+        }
+        return -1;
+    }
+
+    bool isComplete(int64_t currentTime) const override {
+        return currentActive && (disk.headPosition == activeRequest.track);
+    }
+
+    void completeCurrentRequest() override {
+        if (currentActive) {
+            activeRequest.endTime = disk.currentTime;
+            pool.complete(activeRequest);
+            currentActive = false;
+        }
+    }
+
+    void startNextRequest() override {
+        if (!currentActive && !requestList.empty()) {
+            getNextRequest();
+        }
+    }
+
+    void save(SnapshotWriter& out) const override {
+        out.put(currentActive);
+        out.put(activeRequest);
+        requestList.save(out);
+    }
+
+    void restore(SnapshotReader& in) override {
+        in.get(currentActive);
+        in.get(activeRequest);
+        requestList.restore(in);
+    }
+};
+
+// FLOOK scheduling algorithm implementation. Arrivals collect in an
+// incoming index while the active one is swept. Both are kept in track
+// order, so once the sweep is over they are swapped in O(1). The active
+// index takes no inserts during its sweep, so in tree form each dispatch
+// steps on from the request taken before. The flat form, at most 192
+// entries, is searched as usual.
+class FLOOK final : public IOScheduler {
+private:
+    TrackIndex activeQueue{pool}; // Queue currently being serviced
+    TrackIndex incomingQueue{pool}; // Queue for incoming requests
+    IORequest activeRequest;
+    bool currentActive = false;
+    int direction = 1; // 1 for increasing track numbers, -1 for decreasing
+
+public:
+    using IOScheduler::IOScheduler;
+
+    void addRequest(IORequest req) override {
+        incomingQueue.insert(req);
+    }
+
+    IORequest getNextRequest() override {
+        if (!currentActive) {
+            if (activeQueue.empty()) {
+                activeQueue.swap(incomingQueue); // Both queues are already track-ordered
+            }
+
+            auto it = findNextRequest();
+            if (it.found()) {
+                activeRequest = activeQueue.take(it);
+                activeRequest.startTime = disk.currentTime;
+                currentActive = true;
+                return activeRequest;
+            }
+        }
+        return IORequest{}; // Return an empty request if no appropriate one is found
+    }
+
+    TrackIndex::Entry findNextRequest() {
+        PROFILE_PHASE(Select);
+        auto selected = activeQueue.nextFrom(disk.headPosition, direction);
+
+        // If no request found in the current direction, change direction
+        if (!selected.found() && !activeQueue.empty()) {
+            direction *= -1; // Reverse the direction
+            selected = activeQueue.nextFrom(disk.headPosition, direction);
+        }
+
+        return selected;
+    }
+
+    bool hasRequests() const override {
+        return !activeQueue.empty() || !incomingQueue.empty() || currentActive;
+    }
+
+    bool isActive() const override {
+        return currentActive;
+    }
+
+    int getActiveTrack() const override {
+        if (currentActive) {
+            return activeRequest.track;
+        }
+        return -1;
+    }
+
+    bool isComplete(int64_t currentTime) const override {
+        return currentActive && (disk.headPosition == activeRequest.track);
+    }
+
+    void completeCurrentRequest() override {
+        if (currentActive) {
+            activeRequest.endTime = disk.currentTime;
+            pool.complete(activeRequest);
+            currentActive = false;
+        }
+    }
+
+    void startNextRequest() override {
+        if (!currentActive && (!activeQueue.empty() || !incomingQueue.empty())) {
+            getNextRequest();
+        }
+    }
+
+    void save(SnapshotWriter& out) const override {
+        out.put(currentActive);
+        out.put(activeRequest);
+        out.put(direction);
+        activeQueue.save(out);
+        incomingQueue.save(out);
+    }
+
+    void restore(SnapshotReader& in) override {
+        in.get(currentActive);
+        in.get(activeRequest);
+        in.get(direction);
+        activeQueue.restore(in);
+        incomingQueue.restore(in);
+    }
+};
+
+// Deadline scheduling algorithm, after Linux mq-deadline. Pending requests
+// sit in a track-sorted index and, side by side, in a FIFO ordered by
+// arrival. Dispatch sweeps LOOK-style through the sorted index in batches of
+// fifoBatch requests. At the end of each batch, if the oldest request has
+// waited past the deadline, it is dispatched next and the next batch sweeps
+// on from its track. While the disk keeps up, no request waits much past
+// the deadline plus one batch; under saturation every jump costs a seek
+// that the sweep would not have made.
+class DEADLINE final : public IOScheduler {
+private:
+    TrackIndex sorted{pool};                          // Pending requests by (track, id)
+    std::set<std::tuple<int64_t, int, int>> expiry; // The same requests by (arrivalTime, id, track)
+    SchedulerTuning tuning;
+    bool currentActive = false;
+    IORequest activeRequest;
+    int direction = 1; // 1 for increasing track numbers, -1 for decreasing
+    int batched = 0;   // Dispatches so far in the current batch
+    int lowestTrack = INT_MAX; // Range of the tracks requested so far
+    int highestTrack = INT_MIN;
+
+    // The configured deadline, or by default two full-stroke seeks across
+    // the tracks requested so far: about as long as a LOOK sweep that keeps
+    // reversing makes anyone wait, so the deadline fires when the sweep
+    // keeps finding work ahead and leaves a request behind it.
+    int64_t deadline() const {
+        if (tuning.deadline > 0) return tuning.deadline;
+        return std::max<int64_t>(1, std::ceil(2 * cost.seekTime(static_cast<int64_t>(highestTrack) - lowestTrack)));
+    }
+
+public:
+    DEADLINE(const DiskState& diskState, const CostModel& costModel, RequestPool& requestPool,
+             const SchedulerTuning& schedTuning = SchedulerTuning())
+        : IOScheduler(diskState, costModel, requestPool), tuning(schedTuning) {}
+
+    void addRequest(IORequest req) override {
+        sorted.insert(req);
+        expiry.emplace(req.arrivalTime, req.id, req.track);
+        lowestTrack = std::min(lowestTrack, req.track);
+        highestTrack = std::max(highestTrack, req.track);
+    }
+
+    IORequest getNextRequest() override {
+        if (!sorted.empty() && !currentActive) {
+            auto it = findNextRequest();
+            activeRequest = sorted.take(it);
+            expiry.erase({activeRequest.arrivalTime, activeRequest.id, activeRequest.track});
+            activeRequest.startTime = disk.currentTime;
+            currentActive = true;
+            return activeRequest;
+        }
+        return IORequest{};
+    }
+
+    // The oldest request if the batch is over and its deadline has passed,
+    // otherwise the next request of the LOOK sweep. The sweep goes on from
+    // the expired request's track, in the direction the head went to reach it.
+    TrackIndex::Entry findNextRequest() {
+        PROFILE_PHASE(Select);
+        if (batched >= tuning.fifoBatch && !expiry.empty()) {
+            PROFILE_VISIT(1, 1);
+            auto [arrivalTime, id, track] = *expiry.begin();
+            if (disk.currentTime - arrivalTime >= deadline()) {
+                if (track != disk.headPosition) direction = track > disk.headPosition ? 1 : -1;
+                batched = 1;
+                return sorted.find(pool[id]);
+            }
+        }
+
+        auto selected = sorted.nearest(disk.headPosition, direction);
+        if (!selected.found()) {
+            direction = -direction;
+            selected = sorted.nearest(disk.headPosition, direction);
+        }
+        batched = batched >= tuning.fifoBatch ? 1 : batched + 1;
+        return selected;
+    }
+
+    bool hasRequests() const override {
+        return !sorted.empty() || currentActive;
+    }
+
+    bool isActive() const override {
+        return currentActive;
+    }
+
+    int getActiveTrack() const override {
+        if (currentActive) {
+            return activeRequest.track;
+        }
+        return -1;
+    }
+
+    bool isComplete(int64_t currentTime) const override {
+        return currentActive && (disk.headPosition == activeRequest.track);
+    }
+
+    void completeCurrentRequest() override {
+        if (currentActive) {
+            activeRequest.endTime = disk.currentTime;
+            pool.complete(activeRequest);
+            currentActive = false;
+        }
+    }
+
+    void startNextRequest() override {
+        if (!currentActive && !sorted.empty()) {
+            getNextRequest();
+        }
+    }
+
+    void save(SnapshotWriter& out) const override {
+        out.put(currentActive);
+        out.put(activeRequest);
+        out.put(direction);
+        out.put(batched);
+        out.put(lowestTrack);
+        out.put(highestTrack);
+        sorted.save(out);
+    }
+
+    // The FIFO holds the same requests as the sorted index
+    void restore(SnapshotReader& in) override {
+        in.get(currentActive);
+        in.get(activeRequest);
+        in.get(direction);
+        in.get(batched);
+        in.get(lowestTrack);
+        in.get(highestTrack);
+        sorted.restore(in, [&](const IORequest& req) { expiry.emplace(req.arrivalTime, req.id, req.track); });
+    }
+};
+
+// What anticipation did during a run
+struct AnticipationStats {
+    long long windows = 0;  // Times the disk was held idle after a completion
+    long long hits = 0;     // Windows ended early by a nearby arrival
+    long long idleTime = 0; // Time spent holding the disk idle
+
+    void merge(const AnticipationStats& other) {
+        windows += other.windows;
+        hits += other.hits;
+        idleTime += other.idleTime;
+    }
+};
+
+// Anticipatory scheduling wrapped around any of the algorithms above. A
+// reader that issues its next request only after the previous one completed
+// looks idle at the moment of completion, and the base algorithm seeks away
+// to other work. Instead, right after such a completion, the disk may be
+// held idle for a short window. An arrival within anticipationTracks of the
+// completed request's track ends the window and is served at once;
+// otherwise the base algorithm dispatches when the window is over.
+//
+// Traces carry no process ids, so readers are recognized by their pattern:
+// a request that arrives near the track of a recent completion continues a
+// stream. Only the completion of a stream request opens a window. After
+// each such completion the scheduler watches for the follow-up, and keeps
+// moving averages of how often it comes and how long after. It holds the
+// disk only while follow-ups come at least half the time, and for twice
+// their mean delay.
+class ANTICIPATORY final : public IOScheduler {
+private:
+    std::unique_ptr<IOScheduler> base;
+    SchedulerTuning tuning;
+    std::multiset<int> pendingTracks;       // Tracks of the requests queued in the base
+    std::unordered_set<int> streamIds;      // Pending requests that continue a stream
+    std::map<int, int64_t> recent;              // Completions of the last window: time by track
+    std::queue<std::pair<int64_t, int>> expiry; // The same as (time, track), oldest first
+
+    int activeId = -1;           // Request in service, from the base or not
+    bool currentActive = false;  // A follow-up taken past the base is in service
+    IORequest activeRequest;
+    bool hasFollowUp = false;    // A follow-up arrived during a window and waits for dispatch
+    IORequest followUp;
+
+    bool holding = false;
+    int64_t holdStart = 0;
+    int64_t holdEnd = INT64_MAX;
+
+    bool observing = false;      // Watching for the follow-up of a stream request
+    int anchorTrack = 0;
+    int64_t anchorTime = 0;
+    double hitRate = 0.5;        // Moving average of how often the follow-up comes
+    double meanGap = 0;          // Moving average of its delay after the completion
+
+    AnticipationStats counters;
+
+    struct Completion {
+        int64_t time;
+        int track;
+
+        auto fields() { return std::tie(time, track); }
+    };
+
+    bool isNear(int track, int other) const {
+        return std::abs(track - other) <= tuning.anticipationTracks;
+    }
+
+    void learn(bool hit, int64_t gap) {
+        hitRate += ((hit ? 1.0 : 0.0) - hitRate) / 8;
+        if (hit) meanGap += (gap - meanGap) / 8;
+    }
+
+    // Forget completions older than the longest window, and count a
+    // follow-up that did not come within it as a miss
+    void expire() {
+        int64_t oldest = disk.currentTime - tuning.anticipation;
+        while (!expiry.empty() && expiry.front().first < oldest) {
+            auto [time, track] = expiry.front();
+            auto it = recent.find(track);
+            if (it != recent.end() && it->second == time) recent.erase(it);
+            expiry.pop();
+        }
+        if (observing && anchorTime < oldest) {
+            learn(false, 0);
+            observing = false;
+        }
+    }
+
+    // Hold only right after a stream request completed, when there is other
+    // work the base would seek to and nothing pending near the head already
+    bool shouldHold() const {
+        if (!observing || anchorTime != disk.currentTime || hitRate < 0.5 || !base->hasRequests()) {
+            return false;
+        }
+        auto near = pendingTracks.lower_bound(anchorTrack - tuning.anticipationTracks);
+        return near == pendingTracks.end() || !isNear(*near, anchorTrack);
+    }
+
+    int window() const {
+        return std::clamp(static_cast<int>(std::ceil(2 * meanGap)), 1, tuning.anticipation);
+    }
+
+public:
+    ANTICIPATORY(const DiskState& diskState, const CostModel& costModel, RequestPool& requestPool,
+                 std::unique_ptr<IOScheduler> baseScheduler, const SchedulerTuning& schedTuning)
+        : IOScheduler(diskState, costModel, requestPool), base(std::move(baseScheduler)), tuning(schedTuning),
+          meanGap(schedTuning.anticipation / 2.0) {}
+
+    const AnticipationStats& stats() const { return counters; }
+
+    void addRequest(IORequest req) override {
+        expire();
+        auto near = recent.lower_bound(req.track - tuning.anticipationTracks);
+        if (near != recent.end() && isNear(near->first, req.track)) {
+            streamIds.insert(req.id);
+        }
+
+        if (observing && isNear(req.track, anchorTrack)) {
+            learn(true, disk.currentTime - anchorTime);
+            observing = false;
+            if (holding) {
+                holding = false;
+                counters.hits++;
+                counters.idleTime += disk.currentTime - holdStart;
+                pool.store(req);
+                followUp = req;
+                hasFollowUp = true;
+                return;
+            }
+        }
+        pendingTracks.insert(req.track);
+        base->addRequest(req);
+    }
+
+    IORequest getNextRequest() override {
+        if (isActive()) {
+            return IORequest{};
+        }
+        if (hasFollowUp) {
+            activeRequest = followUp;
+            activeRequest.startTime = disk.currentTime;
+            activeId = activeRequest.id;
+            hasFollowUp = false;
+            currentActive = true;
+            return activeRequest;
+        }
+        if (holding) {
+            if (disk.currentTime < holdEnd) {
+                return IORequest{};
+            }
+            holding = false;
+            counters.idleTime += holdEnd - holdStart;
+        } else if (shouldHold()) {
+            holding = true;
+            holdStart = disk.currentTime;
+            holdEnd = disk.currentTime + window();
+            counters.windows++;
+            return IORequest{};
+        }
+
+        IORequest req = base->getNextRequest();
+        if (base->isActive()) {
+            pendingTracks.erase(pendingTracks.find(req.track));
+            activeId = req.id;
+        }
+        return req;
+    }
+
+    int64_t wakeTime() const override {
+        return holding ? holdEnd : INT64_MAX;
+    }
+
+    bool hasRequests() const override {
+        return currentActive || hasFollowUp || base->hasRequests();
+    }
+
+    bool isActive() const override {
+        return currentActive || base->isActive();
+    }
+
+    int getActiveTrack() const override {
+        return currentActive ? activeRequest.track : base->getActiveTrack();
+    }
+
+    bool isComplete(int64_t currentTime) const override {
+        return currentActive ? disk.headPosition == activeRequest.track : base->isComplete(currentTime);
+    }
+
+    // Complete the request, remember where it ended, and start watching
+    // for its follow-up if it belongs to a stream
+    void completeCurrentRequest() override {
+        if (!isActive()) {
+            return;
+        }
+        if (currentActive) {
+            activeRequest.endTime = disk.currentTime;
+            pool.complete(activeRequest);
+            currentActive = false;
+        } else {
+            base->completeCurrentRequest();
+        }
+        expire();
+        if (streamIds.erase(activeId)) {
+            observing = true;
+            anchorTrack = disk.headPosition;
+            anchorTime = disk.currentTime;
+        }
+        recent[disk.headPosition] = disk.currentTime;
+        expiry.emplace(disk.currentTime, disk.headPosition);
+    }
+
+    void startNextRequest() override {
+        if (!isActive() && hasRequests()) {
+            getNextRequest();
+        }
+    }
+
+    void save(SnapshotWriter& out) const override {
+        base->save(out);
+        out.putVector(std::vector<int>(pendingTracks.begin(), pendingTracks.end()));
+        out.putVector(std::vector<int>(streamIds.begin(), streamIds.end()));
+        std::vector<Completion> completions;
+        for (const auto& [track, time] : recent) completions.push_back({time, track});
+        out.putVector(completions);
+        completions.clear();
+        for (auto pending = expiry; !pending.empty(); pending.pop()) {
+            completions.push_back({pending.front().first, pending.front().second});
+        }
+        out.putVector(completions);
+
+        out.put(activeId);
+        out.put(currentActive);
+        out.put(activeRequest);
+        out.put(hasFollowUp);
+        if (hasFollowUp) {
+            out.put(followUp);
+        }
+        out.put(holding);
+        out.put(holdStart);
+        out.put(holdEnd);
+        out.put(observing);
+        out.put(anchorTrack);
+        out.put(anchorTime);
+        out.put(hitRate);
+        out.put(meanGap);
+        out.put(counters);
+    }
+
+    void restore(SnapshotReader& in) override {
+        base->restore(in);
+        std::vector<int> values;
+        in.getVector(values);
+        pendingTracks.insert(values.begin(), values.end());
+        in.getVector(values);
+        streamIds.insert(values.begin(), values.end());
+        std::vector<Completion> completions;
+        in.getVector(completions);
+        for (const auto& c : completions) recent[c.track] = c.time;
+        in.getVector(completions);
+        for (const auto& c : completions) expiry.emplace(c.time, c.track);
+
+        in.get(activeId);
+        in.get(currentActive);
+        in.get(activeRequest);
+        in.get(hasFollowUp);
+        if (hasFollowUp) {
+            restoreRequest(in, pool, followUp);
+        }
+        in.get(holding);
+        in.get(holdStart);
+        in.get(holdEnd);
+        in.get(observing);
+        in.get(anchorTrack);
+        in.get(anchorTime);
+        in.get(hitRate);
+        in.get(meanGap);
+        in.get(counters);
+    }
+};
+
+// Source of IO requests in arrival order
+class TraceSource {
+public:
+    virtual ~TraceSource() {}
+
+    // Fetch the next request; returns false once the trace is exhausted
+    virtual bool next(IORequest& req) = 0;
+
+    // Pass over the next `count` requests, as when resuming from a
+    // checkpoint. Returns how many there were.
+    virtual long long skip(long long count) {
+        IORequest req;
+        long long skipped = 0;
+        while (skipped < count && next(req)) {
+            skipped++;
+        }
+        return skipped;
+    }
+};
+
+// Function to print IO requests
+inline void printRequests(const std::vector<IORequest>& requests) {
+    std::cout << "Total IO Requests: " << requests.size() << std::endl;
+    for (const auto& req : requests) {
+        std::cout << "Arrival Time: " << req.arrivalTime << ", Track: " << req.track << std::endl;
+    }
+}
+
+// Summary figures reported on the SUM: line
+struct Statistics {
+    int64_t total_time = 0;
+    int64_t total_movement = 0;
+    double io_utilization = 0;
+    double avg_turnaround = 0;
+    double avg_waittime = 0;
+    int64_t max_waittime = 0;
+};
+
+// Running totals behind the SUM: line, updated as each request completes
+struct RunningStats {
+    long long count = 0;
+    int64_t lastEnd = 0;
+    long long totalTurnaround = 0;
+    long long totalWait = 0;
+    int64_t maxWait = 0;
+
+    void add(const IORequest& req) {
+        count++;
+        lastEnd = std::max(lastEnd, req.endTime);
+        totalTurnaround += req.endTime - req.arrivalTime;
+        totalWait += req.startTime - req.arrivalTime;
+        maxWait = std::max(maxWait, req.startTime - req.arrivalTime);
+    }
+
+    void merge(const RunningStats& other) {
+        count += other.count;
+        lastEnd = std::max(lastEnd, other.lastEnd);
+        totalTurnaround += other.totalTurnaround;
+        totalWait += other.totalWait;
+        maxWait = std::max(maxWait, other.maxWait);
+    }
+
+    // io_utilization is the share of the run the disk spent servicing
+    // requests. Under the default cost model that is exactly the head movement.
+    Statistics summarize(int64_t totalMovement, int64_t busyTime) const {
+        Statistics stats;
+        if (count == 0) {
+            return stats;
+        }
+        stats.total_time = lastEnd;
+        stats.total_movement = totalMovement;
+        stats.io_utilization = (double)busyTime / stats.total_time;
+        stats.avg_turnaround = (double)totalTurnaround / count;
+        stats.avg_waittime = (double)totalWait / count;
+        stats.max_waittime = maxWait;
+        return stats;
+    }
+};
+
+// Wait time split at the device queue under native command queuing: time in
+// the host scheduler until the command is issued, then in the device queue
+// until the device starts it
+struct QueueWaits {
+    long long count = 0;
+    long long hostWait = 0;
+    long long deviceWait = 0;
+    int64_t maxHostWait = 0;
+    int64_t maxDeviceWait = 0;
+
+    void add(int64_t host, int64_t device) {
+        count++;
+        hostWait += host;
+        deviceWait += device;
+        maxHostWait = std::max(maxHostWait, host);
+        maxDeviceWait = std::max(maxDeviceWait, device);
+    }
+
+    void merge(const QueueWaits& other) {
+        count += other.count;
+        hostWait += other.hostWait;
+        deviceWait += other.deviceWait;
+        maxHostWait = std::max(maxHostWait, other.maxHostWait);
+        maxDeviceWait = std::max(maxDeviceWait, other.maxDeviceWait);
+    }
+};
+
+// "NCQ: depth=.. host_wait=.. device_wait=.. max_host=.. max_device=.."
+inline void printQueueWaits(std::ostream& out, int depth, const QueueWaits& waits) {
+    double count = std::max<long long>(waits.count, 1);
+    out << "NCQ: depth=" << depth << " host_wait=" << std::fixed << std::setprecision(2) << waits.hostWait / count
+        << " device_wait=" << waits.deviceWait / count << " max_host=" << waits.maxHostWait
+        << " max_device=" << waits.maxDeviceWait << "\n";
+}
+
+inline void printSummary(std::ostream& out, const Statistics& stats) {
+    out << "SUM: " << stats.total_time << " " << stats.total_movement << " " << std::fixed << std::setprecision(4) << stats.io_utilization << " "
+        << std::fixed << std::setprecision(2) << stats.avg_turnaround << " " << stats.avg_waittime << " " << stats.max_waittime << "\n";
+}
+
+// Latency distributions of one run, recorded as requests complete
+struct LatencyHistograms {
+    Histogram wait;
+    Histogram turnaround;
+    Histogram seek; // Tracks moved to reach each request
+
+    void record(const IORequest& req, int64_t seekDistance) {
+        wait.record(req.startTime - req.arrivalTime);
+        turnaround.record(req.endTime - req.arrivalTime);
+        seek.record(seekDistance);
+    }
+
+    void merge(const LatencyHistograms& other) {
+        wait.merge(other.wait);
+        turnaround.merge(other.turnaround);
+        seek.merge(other.seek);
+    }
+};
+
+// One line per distribution: "LAT <name>: p50=... p90=... p99=... p99.9=... max=..."
+inline void printPercentiles(std::ostream& out, const LatencyHistograms& latency, const std::string& prefix = "") {
+    const std::pair<const char*, const Histogram*> rows[] = {
+        {"wait", &latency.wait}, {"turnaround", &latency.turnaround}, {"seek", &latency.seek}};
+    for (const auto& [name, hist] : rows) {
+        out << prefix << "LAT " << name << ": p50=" << hist->percentile(0.5) << " p90=" << hist->percentile(0.9)
+            << " p99=" << hist->percentile(0.99) << " p99.9=" << hist->percentile(0.999) << " max=" << hist->max() << "\n";
+    }
+}
+
+// One JSON object per line with the buckets of each distribution
+inline void writeLatencyJson(std::ostream& out, char algorithm, const LatencyHistograms& latency) {
+    out << "{\"algo\":\"" << algorithm << "\",\"wait\":";
+    latency.wait.writeJson(out);
+    out << ",\"turnaround\":";
+    latency.turnaround.writeJson(out);
+    out << ",\"seek\":";
+    latency.seek.writeJson(out);
+    out << "}\n";
+}
+
+// "<id>: <arrival> <start> <end>" for one completed request
+inline void printRequestLine(const IORequest& req) {
+    std::cout << std::right << std::setw(5) << req.id << ":"
+              << std::setw(6) << req.arrivalTime
+              << std::setw(6) << req.startTime
+              << std::setw(6) << req.endTime << std::endl;
+}
+
+// Print one line per completed request, in order of their ID
+inline void printCompletedRequests(const RequestPool& pool) {
+    pool.forEachCompleted(printRequestLine);
+}
+
+// Create the scheduler for an algorithm letter, or nullptr if it is unknown.
+// With an anticipation window it is wrapped in ANTICIPATORY.
+inline std::unique_ptr<IOScheduler> createScheduler(char schedulerType, const DiskState& disk, const CostModel& cost,
+                                                    RequestPool& pool, const SchedulerTuning& tuning = SchedulerTuning()) {
+    std::unique_ptr<IOScheduler> sched;
+    switch (schedulerType) {
+        case 'N': sched = std::make_unique<FIFO>(disk, cost, pool); break;
+        case 'S': sched = std::make_unique<SSTF>(disk, cost, pool); break;
+        case 'L': sched = std::make_unique<LOOK>(disk, cost, pool); break;
+        case 'C': sched = std::make_unique<CLOOK>(disk, cost, pool); break;
+        case 'F': sched = std::make_unique<FLOOK>(disk, cost, pool); break;
+        case 'D': sched = std::make_unique<DEADLINE>(disk, cost, pool, tuning); break;
+        default: return nullptr;
+    }
+    if (tuning.anticipation > 0) {
+        return std::make_unique<ANTICIPATORY>(disk, cost, pool, std::move(sched), tuning);
+    }
+    return sched;
+}
+
+// Coalescing stage in front of a scheduler. An arrival on the same track as
+// a pending request, or on a track next to it, is merged into that request
+// (its host) and never reaches the scheduler. It rides along with the host's
+// dispatch and completes together with it.
+class Coalescer {
+private:
+    std::map<int, int> hosts; // Pending hosts by track; at most one per track
+    std::unordered_map<int, std::vector<int>> riders; // Rider ids by host id
+
+public:
+    long long merges = 0; // Dispatches saved
+
+    // Merge the request into a pending host, or register it as a host if
+    // there is none nearby. Returns true if it was merged; merged requests
+    // are stored in the pool.
+    bool absorb(const IORequest& req, RequestPool& pool) {
+        for (int track : {req.track, req.track - 1, req.track + 1}) {
+            auto it = hosts.find(track);
+            if (it != hosts.end()) {
+                pool.store(req);
+                riders[it->second].push_back(req.id);
+                merges++;
+                return true;
+            }
+        }
+        hosts.emplace(req.track, req.id);
+        return false;
+    }
+
+    // A host was dispatched and takes no more riders; hand over their ids
+    std::vector<int> dispatch(const IORequest& host) {
+        hosts.erase(host.track);
+        auto it = riders.find(host.id);
+        if (it == riders.end()) {
+            return {};
+        }
+        std::vector<int> group = std::move(it->second);
+        riders.erase(it);
+        return group;
+    }
+
+    // Checkpointing: the hosts by track, and the riders of each host in full
+    void save(SnapshotWriter& out, const RequestPool& pool) const {
+        out.put(merges);
+        out.put<uint64_t>(hosts.size());
+        for (const auto& [track, id] : hosts) {
+            out.put(track);
+            out.put(id);
+        }
+        out.put<uint64_t>(riders.size());
+        for (const auto& [host, group] : riders) {
+            out.put(host);
+            out.put<uint64_t>(group.size());
+            for (int id : group) {
+                out.put(pool[id]);
+            }
+        }
+    }
+
+    void restore(SnapshotReader& in, RequestPool& pool) {
+        in.get(merges);
+        size_t count = in.getCount(2 * sizeof(int));
+        for (size_t i = 0; i < count; i++) {
+            int track = in.get<int>();
+            hosts.emplace(track, in.get<int>());
+        }
+        count = in.getCount(sizeof(int) + sizeof(uint64_t));
+        for (size_t i = 0; i < count && in.ok(); i++) {
+            std::vector<int>& group = riders[in.get<int>()];
+            size_t size = in.getCount(snapshotSize<IORequest>());
+            IORequest req;
+            for (size_t j = 0; j < size && restoreRequest(in, pool, req); j++) {
+                group.push_back(req.id);
+            }
+        }
+    }
+};
+
+// One self-contained simulation: a disk, its cost model, its clock and a scheduler. All
+// state lives in the object, so independent simulators can run on
+// different threads at the same time.
+//
+// run() replays a whole trace. Callers that drive the clock themselves use
+// the step API instead: addRequest() for arrivals, processCurrentTime() at
+// every event, and advanceTo() to jump to the next event, which must not be
+// later than completionTime(). planNext() runs a stretch of back-to-back
+// dispatches in one call.
+//
+// The built-in schedulers are final, and the hot loops are templates over
+// the concrete scheduler type, instantiated once per algorithm. The calls
+// into the scheduler are then resolved at compile time.
+//
+// Requests live in a RequestPool indexed by id. Simulators that replay
+// parts of one trace, such as the devices of an array, can share a pool.
+class Simulator {
+private:
+    DiskState disk;
+    CostModel cost;
+    std::shared_ptr<RequestPool> pool;
+    std::unique_ptr<IOScheduler> scheduler;
+    char schedulerType = 0;
+    bool busy = false;        // A request is in service
+    int activeId = 0;         // Id of the request in service
+    int64_t activeCompletion = 0; // When the active request finishes
+    int64_t activeSeek = 0;   // Tracks moved to reach the active request
+    int activeLanding = 0;    // Track the head ends up on
+    RunningStats totals;
+    LatencyHistograms latency;
+    std::unique_ptr<Coalescer> coalescer;   // Only when coalescing is enabled
+    ANTICIPATORY* anticipator = nullptr;    // The scheduler, when it anticipates
+    std::vector<int> activeRiders;          // Ids of the requests merged into the active one
+    std::vector<IORequest>* completionLog = nullptr; // Collects completions during planNext()
+    std::function<void(const IORequest&)> sink;      // Receives completions in streaming mode
+    std::vector<IORequest> arrivals;                 // Arrivals admitted together by run()
+
+    // Native command queuing. With a queue depth above 1 the scheduler
+    // issues requests into the device's own queue as soon as there is room,
+    // and the device picks which of them to service next.
+    struct DeviceCommand {
+        int id;
+        int track;
+        int64_t issueTime;
+        int passes; // Times the device picked another command instead
+
+        auto fields() { return std::tie(id, track, issueTime, passes); }
+    };
+    int queueDepth = 1;
+    std::vector<DeviceCommand> deviceQueue; // In issue order
+    QueueWaits waits;
+
+    long long admitted = 0;          // Requests run() has taken from the trace
+    std::function<void()> checkpoint; // Called by run() every checkpointInterval time units
+    int checkpointInterval = 0;
+    long long nextCheckpoint = 0;
+
+    profile::Counters profiled; // Filled by run() in profiling builds
+
+    Simulator() = default;
+
+    // Call the checkpoint hook once the clock has passed the next multiple
+    // of the interval. Called only where the loop in runWith() could start
+    // over from the saved state.
+    void maybeCheckpoint() {
+        if (checkpointInterval > 0 && disk.currentTime >= nextCheckpoint) {
+            checkpoint();
+            nextCheckpoint = (disk.currentTime / checkpointInterval + 1) * static_cast<long long>(checkpointInterval);
+        }
+    }
+
+    // Charge the request just dispatched: the head stays where it is until
+    // the service time has passed and then lands on the request's track.
+    // Riders widen the dispatch to the range of their tracks, which the head
+    // covers from the nearer end to the farther one.
+    void beginService(const IORequest& req) {
+        PROFILE_PHASE(HeadMovement);
+        int low = req.track, high = req.track;
+        if (coalescer) {
+            activeRiders = coalescer->dispatch(req);
+            for (int rider : activeRiders) {
+                low = std::min(low, (*pool)[rider].track);
+                high = std::max(high, (*pool)[rider].track);
+            }
+        }
+        int64_t head = disk.headPosition;
+        int nearEnd = std::abs(low - head) <= std::abs(high - head) ? low : high;
+        activeLanding = nearEnd == low ? high : low;
+
+        activeSeek = std::abs(nearEnd - head) + (static_cast<int64_t>(high) - low);
+        disk.totalMovement += activeSeek;
+        if (disk.headPosition < activeLanding) disk.direction = 1;
+        else if (disk.headPosition > activeLanding) disk.direction = -1;
+        else disk.direction = 0;
+
+        int64_t serviceTime = cost.serviceTime(disk.headPosition, nearEnd, req.id, disk.currentTime);
+        if (!activeRiders.empty()) {
+            serviceTime += static_cast<int64_t>(std::ceil(cost.seekTime(static_cast<int64_t>(high) - low) + activeRiders.size() * cost.transferTime()));
+        }
+        activeId = req.id;
+        activeCompletion = disk.currentTime + serviceTime;
+        disk.busyTime += serviceTime;
+        busy = true;
+    }
+
+    // Call f with the scheduler downcast to its concrete type
+    template <typename F>
+    void withScheduler(F&& f) {
+        if (anticipator) {
+            f(*anticipator);
+            return;
+        }
+        switch (schedulerType) {
+            case 'N': f(static_cast<FIFO&>(*scheduler)); break;
+            case 'S': f(static_cast<SSTF&>(*scheduler)); break;
+            case 'L': f(static_cast<LOOK&>(*scheduler)); break;
+            case 'C': f(static_cast<CLOOK&>(*scheduler)); break;
+            case 'F': f(static_cast<FLOOK&>(*scheduler)); break;
+            case 'D': f(static_cast<DEADLINE&>(*scheduler)); break;
+            default: f(*scheduler); break;
+        }
+    }
+
+    // Move requests from the scheduler into the device queue while it has
+    // room. The scheduler is done with a request once it is issued.
+    template <typename Sched>
+    void issueCommands(Sched& sched) {
+        PROFILE_PHASE(Dispatch);
+        while (deviceQueue.size() < static_cast<size_t>(queueDepth) && sched.hasRequests()) {
+            IORequest req = sched.getNextRequest();
+            if (!sched.isActive()) {
+                break;
+            }
+            sched.completeCurrentRequest();
+            deviceQueue.push_back({req.id, req.track, disk.currentTime, 0});
+        }
+    }
+
+    // The device's choice among its queued commands: the shortest
+    // positioning time from the head, the earlier arrival on ties. The
+    // oldest command is taken first once it has been passed over 16 times per
+    // queue slot, which bounds how long any command can wait in the device
+    // without giving up much of the reordering.
+    const IORequest& pickCommand() {
+        PROFILE_PHASE(Dispatch);
+        size_t pick = 0;
+        if (deviceQueue.front().passes < queueDepth * 16) {
+            PROFILE_PHASE(Select);
+            PROFILE_VISIT(deviceQueue.size(), deviceQueue.size());
+            double bestTime = 0;
+            for (size_t i = 0; i < deviceQueue.size(); i++) {
+                const DeviceCommand& cmd = deviceQueue[i];
+                double time = cost.positioningTime(disk.headPosition, cmd.track, cmd.id, disk.currentTime);
+                if (i == 0 || time < bestTime || (time == bestTime && cmd.id < deviceQueue[pick].id)) {
+                    pick = i;
+                    bestTime = time;
+                }
+            }
+        }
+        DeviceCommand cmd = deviceQueue[pick];
+        deviceQueue.erase(deviceQueue.begin() + pick);
+        for (auto& other : deviceQueue) {
+            other.passes++;
+        }
+
+        IORequest& req = (*pool)[cmd.id];
+        req.startTime = disk.currentTime;
+        waits.add(cmd.issueTime - req.arrivalTime, disk.currentTime - cmd.issueTime);
+        return req;
+    }
+
+    template <typename Sched>
+    void step(Sched& sched) {
+        // Check if the current IO operation is complete
+        if (busy && disk.currentTime >= activeCompletion) {
+            finishService(sched);
+        }
+
+        if (queueDepth > 1) {
+            issueCommands(sched);
+            if (!busy && !deviceQueue.empty()) {
+                beginService(pickCommand());
+            }
+            return;
+        }
+
+        // If no IO request is active and there are pending requests, start a new IO operation
+        if (!busy && sched.hasRequests()) {
+            IORequest req = dispatchNext(sched);
+            if (sched.isActive()) {
+                beginService(req);
+            }
+        }
+    }
+
+    // The scheduler's next request, timed as the dispatch phase
+    template <typename Sched>
+    IORequest dispatchNext(Sched& sched) {
+        PROFILE_PHASE(Dispatch);
+        return sched.getNextRequest();
+    }
+
+    // Complete requests back to back while the next completion comes before
+    // `horizon`; no arrival can change the decisions in between
+    template <typename Sched>
+    void serviceUntil(Sched& sched, size_t count, int64_t horizon) {
+        long long before = totals.count;
+        while (busy && activeCompletion < horizon && static_cast<size_t>(totals.count - before) < count) {
+            advanceTo(activeCompletion);
+            maybeCheckpoint();
+            step(sched);
+        }
+    }
+
+    template <typename Sched>
+    void runWith(Sched& sched, TraceSource& trace) {
+        // Requests are pulled from the trace one at a time; only the next
+        // arrival is held here
+        IORequest nextArrival;
+        bool hasArrival = trace.next(nextArrival);
+        if (checkpointInterval > 0) {
+            nextCheckpoint = (disk.currentTime / checkpointInterval + 1) * static_cast<long long>(checkpointInterval);
+        }
+
+        // Discrete-event loop: every pass handles one instant and then jumps
+        // the clock straight to the next event, which is either the next
+        // arrival or the moment the active request's service time is up.
+        // Nothing the schedulers observe changes in between, so the skipped
+        // ticks can be accounted for in one step.
+        while (true) {
+            maybeCheckpoint();
+
+            // Admit every arrival due by now in one batch, so the scheduler
+            // sees all requests that arrived on the same tick before it picks
+            if (hasArrival && nextArrival.arrivalTime <= disk.currentTime) {
+                PROFILE_PHASE(Admission);
+                arrivals.clear();
+                do {
+                    arrivals.push_back(nextArrival);
+                    hasArrival = trace.next(nextArrival);
+                } while (hasArrival && nextArrival.arrivalTime <= disk.currentTime);
+                addRequests(arrivals);
+                admitted += arrivals.size();
+            }
+
+            step(sched);
+
+            // Completions before the next arrival need no arrival checks
+            serviceUntil(sched, SIZE_MAX, hasArrival ? nextArrival.arrivalTime : INT64_MAX);
+
+            // Check if all requests are processed
+            if (!hasArrival && !busy && deviceQueue.empty() && !sched.hasRequests()) {
+                break;
+            }
+
+            // Find the next event: an arrival or the completion of the active request
+            int64_t nextEventTime = completionTime();
+            if (hasArrival) {
+                nextEventTime = std::min(nextEventTime, nextArrival.arrivalTime);
+            }
+            advanceTo(nextEventTime);
+        }
+    }
+
+    void recordCompletion(const IORequest& req) {
+        totals.add(req);
+        if (completionLog) {
+            completionLog->push_back(req);
+        }
+        if (sink) {
+            sink(req);
+            pool->release(req.id);
+        }
+    }
+
+    // Record the active request, and any riders, as completed. The scheduler
+    // writes the host back into the pool, unless it already let go of it at
+    // issue under NCQ; riders are written here.
+    template <typename Sched>
+    void finishService(Sched& sched) {
+        PROFILE_PHASE(Completion);
+        busy = false;
+        if (queueDepth > 1) {
+            IORequest& req = (*pool)[activeId];
+            req.endTime = disk.currentTime;
+            pool->complete(req);
+        } else {
+            sched.completeCurrentRequest();
+        }
+        IORequest host = (*pool)[activeId]; // A copy; the sink may release it
+        latency.record(host, activeSeek);
+        recordCompletion(host);
+        for (int id : activeRiders) {
+            IORequest rider = (*pool)[id];
+            rider.startTime = host.startTime;
+            rider.endTime = host.endTime;
+            pool->complete(rider);
+            latency.wait.record(rider.startTime - rider.arrivalTime);
+            latency.turnaround.record(rider.endTime - rider.arrivalTime);
+            recordCompletion(rider);
+        }
+        activeRiders.clear();
+    }
+
+public:
+    // Create a simulator for an algorithm letter, or nullptr if it is unknown
+    // or the tuning combines anticipation with a device queue: the device
+    // would complete requests the anticipating scheduler still holds.
+    // Without a shared pool the simulator gets one of its own.
+    static std::unique_ptr<Simulator> create(char schedulerType, const CostModel& costModel = CostModel(),
+                                             const SchedulerTuning& tuning = SchedulerTuning(),
+                                             std::shared_ptr<RequestPool> sharedPool = nullptr) {
+        if (tuning.anticipation > 0 && tuning.queueDepth > 1) {
+            return nullptr;
+        }
+        std::unique_ptr<Simulator> sim(new Simulator());
+        sim->cost = costModel;
+        sim->pool = sharedPool ? std::move(sharedPool) : std::make_shared<RequestPool>();
+        sim->schedulerType = schedulerType;
+        sim->scheduler = createScheduler(schedulerType, sim->disk, sim->cost, *sim->pool, tuning);
+        if (!sim->scheduler) {
+            return nullptr;
+        }
+        if (tuning.coalesce) {
+            sim->coalescer = std::make_unique<Coalescer>();
+        }
+        if (tuning.anticipation > 0) {
+            sim->anticipator = static_cast<ANTICIPATORY*>(sim->scheduler.get());
+        }
+        sim->queueDepth = tuning.queueDepth;
+        return sim;
+    }
+
+    Simulator(const Simulator&) = delete;
+    Simulator& operator=(const Simulator&) = delete;
+
+    const DiskState& state() const { return disk; }
+    const CostModel& costModel() const { return cost; }
+    IOScheduler& getScheduler() { return *scheduler; }
+
+    // Admit an arrival. Returns false, and drops it, if its id cannot be a
+    // pool slot: a negative id, or one on a page already freed.
+    bool addRequest(const IORequest& req) {
+        if (!pool->canStore(req.id)) {
+            return false;
+        }
+        if (coalescer && coalescer->absorb(req, *pool)) {
+            return true;
+        }
+        scheduler->addRequest(req);
+        return true;
+    }
+
+    // Add a batch of arrivals, in arrival order. Returns false if any was
+    // dropped; see addRequest().
+    bool addRequests(std::span<const IORequest> reqs) {
+        bool storable = std::all_of(reqs.begin(), reqs.end(), [&](const IORequest& req) { return pool->canStore(req.id); });
+        if (coalescer || !storable) {
+            for (const auto& req : reqs) {
+                addRequest(req);
+            }
+            return storable;
+        }
+        scheduler->addRequests(reqs);
+        return true;
+    }
+
+    // Pending or active requests remain
+    bool hasRequests() const {
+        return busy || !deviceQueue.empty() || scheduler->hasRequests();
+    }
+
+    // Hand each request to `sink` as it completes and then drop it from the
+    // pool, so memory is bounded by the requests in flight rather than by
+    // the length of the trace. printStatistics() then lists no requests.
+    void streamCompletions(std::function<void(const IORequest&)> completionSink) {
+        sink = std::move(completionSink);
+    }
+
+    // Complete the active request if its service time is up, then start the
+    // next one if the disk is idle
+    void processCurrentTime() {
+        withScheduler([this](auto& sched) { step(sched); });
+    }
+
+    // Run up to `count` back-to-back completions, each followed by the next
+    // dispatch, as long as they finish before `horizon` (the next arrival,
+    // if any). Returns the requests completed, which are the scheduler's
+    // next dispatch decisions in order.
+    std::vector<IORequest> planNext(size_t count, int64_t horizon = INT64_MAX) {
+        std::vector<IORequest> completed;
+        completionLog = &completed;
+        withScheduler([&](auto& sched) { serviceUntil(sched, count, horizon); });
+        completionLog = nullptr;
+        return completed;
+    }
+
+    // Time of the next event inside the simulator: the completion of the
+    // active request or, while an anticipating scheduler holds the disk
+    // idle, the end of its window. INT64_MAX if there is none.
+    int64_t completionTime() const {
+        if (!busy) {
+            return scheduler->wakeTime();
+        }
+        return activeCompletion;
+    }
+
+    // Advance the clock. The head reaches the active request's track when its
+    // service time is up; positions in the middle of a seek are never observed.
+    void advanceTo(int64_t time) {
+        PROFILE_PHASE(HeadMovement);
+        if (time > disk.currentTime) {
+            disk.currentTime = time;
+        }
+        if (busy && disk.currentTime >= activeCompletion) {
+            disk.headPosition = activeLanding;
+        }
+    }
+
+    // Run the trace to completion
+    void run(TraceSource& trace) {
+        PROFILE_RUN(profiled);
+        withScheduler([&](auto& sched) { runWith(sched, trace); });
+    }
+
+    // All requests, completed ones with their start and end times
+    const RequestPool& requests() const { return *pool; }
+
+    // Requests completed so far, including those merged into another's dispatch
+    long long completedCount() const { return totals.count; }
+
+    const RunningStats& runningStats() const { return totals; }
+
+    // Dispatches saved by coalescing
+    long long merges() const {
+        return coalescer ? coalescer->merges : 0;
+    }
+
+    const LatencyHistograms& latencyHistograms() const { return latency; }
+
+    AnticipationStats anticipation() const {
+        return anticipator ? anticipator->stats() : AnticipationStats();
+    }
+
+    // Host and device share of the wait; empty without a device queue
+    const QueueWaits& queueWaits() const { return waits; }
+
+    // Have run() call `hook` each time the clock passes a multiple of
+    // `interval`, at a point where save() captures all it needs to go on
+    void checkpointEvery(int interval, std::function<void()> hook) {
+        checkpointInterval = interval;
+        checkpoint = std::move(hook);
+    }
+
+    // Requests run() has taken from the trace. A run resumed from a
+    // snapshot continues with the trace past this many requests.
+    long long admittedCount() const { return admitted; }
+
+    // Phase timings and selection counts of run(); all zero unless built
+    // with IOSCHED_PROFILE
+    const profile::Counters& profileCounters() const { return profiled; }
+
+    // Checkpointing: the clock, head, running totals, pending requests and
+    // scheduler state. Completed requests are not kept. restore() expects a
+    // simulator created with the same algorithm and options, and returns
+    // false if the snapshot does not fit it. Devices that share a pool leave
+    // it out, and their owner writes it once ahead of them.
+    void save(SnapshotWriter& out, bool withPool = true) const {
+        if (withPool) {
+            pool->save(out);
+        }
+        out.put(schedulerType);
+        out.put(queueDepth);
+        out.put(coalescer != nullptr);
+        out.put(anticipator != nullptr);
+        out.put(disk);
+        out.put(busy);
+        out.put(activeId);
+        out.put(activeCompletion);
+        out.put(activeSeek);
+        out.put(activeLanding);
+        out.put(admitted);
+        out.put(totals);
+        latency.wait.save(out);
+        latency.turnaround.save(out);
+        latency.seek.save(out);
+        out.put(waits);
+
+        out.put<uint64_t>(activeRiders.size());
+        for (int id : activeRiders) {
+            out.put((*pool)[id]);
+        }
+        if (coalescer) {
+            coalescer->save(out, *pool);
+        }
+        // Issued commands were already handed back by the scheduler
+        out.put<uint64_t>(deviceQueue.size());
+        for (const auto& cmd : deviceQueue) {
+            out.put(cmd);
+            out.put((*pool)[cmd.id]);
+        }
+        if (queueDepth > 1 && busy) {
+            out.put((*pool)[activeId]);
+        }
+        scheduler->save(out);
+    }
+
+    bool restore(SnapshotReader& in, bool withPool = true) {
+        if (withPool) {
+            pool->restore(in);
+        }
+        if (in.get<char>() != schedulerType || in.get<int>() != queueDepth ||
+            in.get<bool>() != (coalescer != nullptr) || in.get<bool>() != (anticipator != nullptr)) {
+            return false;
+        }
+        in.get(disk);
+        in.get(busy);
+        in.get(activeId);
+        in.get(activeCompletion);
+        in.get(activeSeek);
+        in.get(activeLanding);
+        in.get(admitted);
+        in.get(totals);
+        latency.wait.restore(in);
+        latency.turnaround.restore(in);
+        latency.seek.restore(in);
+        in.get(waits);
+
+        IORequest req;
+        size_t count = in.getCount(snapshotSize<IORequest>());
+        for (size_t i = 0; i < count && restoreRequest(in, *pool, req); i++) {
+            activeRiders.push_back(req.id);
+        }
+        if (coalescer) {
+            coalescer->restore(in, *pool);
+        }
+        count = in.getCount(snapshotSize<DeviceCommand>() + snapshotSize<IORequest>());
+        for (size_t i = 0; i < count; i++) {
+            DeviceCommand cmd = in.get<DeviceCommand>();
+            if (!restoreRequest(in, *pool, req)) break;
+            cmd.id = req.id;
+            pool->complete(req);
+            deviceQueue.push_back(cmd);
+        }
+        if (queueDepth > 1 && busy && restoreRequest(in, *pool, req)) {
+            activeId = req.id;
+            pool->complete(req);
+        }
+        scheduler->restore(in);
+        return in.ok();
+    }
+
+    Statistics statistics() const {
+        return totals.summarize(disk.totalMovement, disk.busyTime);
+    }
+
+    // Print the per-request lines and the SUM: line
+    void printStatistics() const {
+        printCompletedRequests(*pool);
+        if (totals.count > 0) {
+            printSummary(std::cout, statistics());
+        }
+    }
+};
+
+#endif // IOSCHED_H
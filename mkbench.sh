@@ -0,0 +1,26 @@
+#!/bin/bash
+
+# Writes a synthetic trace in the same format as tests/input*, with Poisson
+# arrivals (rate <lambda> per time unit) on uniformly distributed tracks.
+# The defaults produce the 1M-request deep-queue benchmark input:
+#
+#   ./mkbench.sh bench_1m
+#   time ./iosched -sS bench_1m > /dev/null
+
+[[ ${#} -lt 1 ]] && echo "usage: $0 <outputfile> [numio] [maxtracks] [lambda] [seed]" && exit
+
+OUTFILE=$1
+NUMIO=${2:-1000000}
+MAXTRACKS=${3:-1000000}
+LAMBDA=${4:-0.5}
+SEED=${5:-1}
+
+awk -v numio=${NUMIO} -v maxtracks=${MAXTRACKS} -v lambda=${LAMBDA} -v seed=${SEED} 'BEGIN {
+    srand(seed)
+    printf "#io generator\n#numio=%d maxtracks=%d lambda=%f\n", numio, maxtracks, lambda
+    t = 1
+    for (i = 0; i < numio; i++) {
+        printf "%d %d\n", int(t), int(rand() * maxtracks)
+        t += -log(1 - rand()) / lambda
+    }
+}' > ${OUTFILE}
@@ -0,0 +1,213 @@
+#ifndef NEAREST_H
+#define NEAREST_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <climits>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define IOSCHED_X86 1
+#endif
+
+// Nearest-track search over tracks and ids stored as contiguous int32
+// arrays. The result is the slot with the smallest distance from the head,
+// ties going to the lowest id, which matches the order of the tree index.
+// The vector kernels evaluate 8 (AVX2) or 4 (SSE4.1) candidates per
+// instruction. The variant is chosen once at run time from the CPU's
+// features.
+namespace nearest {
+
+enum class Side { Up, Down, Either }; // At or above, at or below, or either side of the head
+
+// Distances are unsigned, so they are exact for any pair of ints. Tracks
+// on the wrong side get UINT32_MAX.
+template <Side S>
+inline uint32_t distance(int track, int head) {
+    uint32_t t = static_cast<uint32_t>(track), h = static_cast<uint32_t>(head);
+    if (S == Side::Up) return track >= head ? t - h : UINT32_MAX;
+    if (S == Side::Down) return track <= head ? h - t : UINT32_MAX;
+    return track >= head ? t - h : h - t;
+}
+
+struct Best {
+    uint32_t dist = UINT32_MAX;
+    int id = INT_MAX;
+    size_t slot = SIZE_MAX;
+
+    void consider(uint32_t d, int candidateId, size_t candidateSlot) {
+        if (d < dist || (d == dist && candidateId < id)) {
+            dist = d;
+            id = candidateId;
+            slot = candidateSlot;
+        }
+    }
+};
+
+template <Side S>
+inline void scanScalar(const int* tracks, const int* ids, size_t from, size_t n, int head, Best& best) {
+    for (size_t i = from; i < n; i++) {
+        best.consider(distance<S>(tracks[i], head), ids[i], i);
+    }
+}
+
+#ifdef IOSCHED_X86
+// The vector kernels make three passes: the smallest distance, the lowest id
+// at that distance, and the slot holding that id. Each pass is a chain of a
+// single min or compare per vector, and the data is small enough to stay in
+// L1 between passes.
+__attribute__((target("avx2"))) inline __m256i loadAvx2(const int* p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+
+template <Side S>
+__attribute__((target("avx2"))) inline __m256i distanceAvx2(__m256i t, __m256i h) {
+    if (S == Side::Up) return _mm256_or_si256(_mm256_sub_epi32(t, h), _mm256_cmpgt_epi32(h, t));
+    if (S == Side::Down) return _mm256_or_si256(_mm256_sub_epi32(h, t), _mm256_cmpgt_epi32(t, h));
+    return _mm256_sub_epi32(_mm256_max_epi32(t, h), _mm256_min_epi32(t, h));
+}
+
+template <Side S>
+__attribute__((target("avx2"))) inline void scanAvx2(const int* tracks, const int* ids, size_t n, int head, Best& best) {
+    size_t vecEnd = n & ~size_t(7);
+    if (vecEnd == 0) {
+        scanScalar<S>(tracks, ids, 0, n, head, best);
+        return;
+    }
+    const __m256i h = _mm256_set1_epi32(head);
+
+    __m256i minDist = _mm256_set1_epi32(-1); // UINT32_MAX
+    for (size_t i = 0; i < vecEnd; i += 8) {
+        minDist = _mm256_min_epu32(minDist, distanceAvx2<S>(loadAvx2(tracks + i), h));
+    }
+    uint32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), minDist);
+    uint32_t d = *std::min_element(lanes, lanes + 8);
+
+    const __m256i target = _mm256_set1_epi32(static_cast<int>(d));
+    __m256i minId = _mm256_set1_epi32(INT_MAX);
+    for (size_t i = 0; i < vecEnd; i += 8) {
+        __m256i match = _mm256_cmpeq_epi32(distanceAvx2<S>(loadAvx2(tracks + i), h), target);
+        minId = _mm256_min_epi32(minId, _mm256_blendv_epi8(_mm256_set1_epi32(INT_MAX), loadAvx2(ids + i), match));
+    }
+    int idLanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(idLanes), minId);
+    int id = *std::min_element(idLanes, idLanes + 8);
+
+    const __m256i wanted = _mm256_set1_epi32(id);
+    for (size_t i = 0; i < vecEnd; i += 8) {
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(loadAvx2(ids + i), wanted)));
+        if (mask) {
+            best.consider(d, id, i + __builtin_ctz(mask));
+            break;
+        }
+    }
+    scanScalar<S>(tracks, ids, vecEnd, n, head, best);
+}
+
+__attribute__((target("sse4.1"))) inline __m128i loadSse41(const int* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+template <Side S>
+__attribute__((target("sse4.1"))) inline __m128i distanceSse41(__m128i t, __m128i h) {
+    if (S == Side::Up) return _mm_or_si128(_mm_sub_epi32(t, h), _mm_cmpgt_epi32(h, t));
+    if (S == Side::Down) return _mm_or_si128(_mm_sub_epi32(h, t), _mm_cmpgt_epi32(t, h));
+    return _mm_sub_epi32(_mm_max_epi32(t, h), _mm_min_epi32(t, h));
+}
+
+template <Side S>
+__attribute__((target("sse4.1"))) inline void scanSse41(const int* tracks, const int* ids, size_t n, int head, Best& best) {
+    size_t vecEnd = n & ~size_t(3);
+    if (vecEnd == 0) {
+        scanScalar<S>(tracks, ids, 0, n, head, best);
+        return;
+    }
+    const __m128i h = _mm_set1_epi32(head);
+
+    __m128i minDist = _mm_set1_epi32(-1);
+    for (size_t i = 0; i < vecEnd; i += 4) {
+        minDist = _mm_min_epu32(minDist, distanceSse41<S>(loadSse41(tracks + i), h));
+    }
+    uint32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), minDist);
+    uint32_t d = *std::min_element(lanes, lanes + 4);
+
+    const __m128i target = _mm_set1_epi32(static_cast<int>(d));
+    __m128i minId = _mm_set1_epi32(INT_MAX);
+    for (size_t i = 0; i < vecEnd; i += 4) {
+        __m128i match = _mm_cmpeq_epi32(distanceSse41<S>(loadSse41(tracks + i), h), target);
+        minId = _mm_min_epi32(minId, _mm_blendv_epi8(_mm_set1_epi32(INT_MAX), loadSse41(ids + i), match));
+    }
+    int idLanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(idLanes), minId);
+    int id = *std::min_element(idLanes, idLanes + 4);
+
+    const __m128i wanted = _mm_set1_epi32(id);
+    for (size_t i = 0; i < vecEnd; i += 4) {
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(loadSse41(ids + i), wanted)));
+        if (mask) {
+            best.consider(d, id, i + __builtin_ctz(mask));
+            break;
+        }
+    }
+    scanScalar<S>(tracks, ids, vecEnd, n, head, best);
+}
+#endif
+
+enum class Isa { Scalar, Sse41, Avx2 };
+
+// Widest instruction set the CPU supports. IOSCHED_SIMD=scalar|sse4.1|avx2
+// caps it, which is how the variants are checked against each other.
+inline Isa detectIsa() {
+    Isa isa = Isa::Scalar;
+#ifdef IOSCHED_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) isa = Isa::Avx2;
+    else if (__builtin_cpu_supports("sse4.1")) isa = Isa::Sse41;
+#endif
+    if (const char* cap = std::getenv("IOSCHED_SIMD")) {
+        if (std::strcmp(cap, "scalar") == 0) isa = Isa::Scalar;
+        else if (std::strcmp(cap, "sse4.1") == 0 && isa == Isa::Avx2) isa = Isa::Sse41;
+    }
+    return isa;
+}
+
+inline Isa activeIsa() {
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+inline const char* isaName(Isa isa) {
+    switch (isa) {
+        case Isa::Avx2: return "avx2";
+        case Isa::Sse41: return "sse4.1";
+        default: return "scalar";
+    }
+}
+
+// Slot of the nearest track on the given side of the head, or n if there
+// is none
+template <Side S>
+inline size_t find(const int* tracks, const int* ids, size_t n, int head) {
+    Best best;
+    switch (activeIsa()) {
+#ifdef IOSCHED_X86
+        case Isa::Avx2: scanAvx2<S>(tracks, ids, n, head, best); break;
+        case Isa::Sse41: scanSse41<S>(tracks, ids, n, head, best); break;
+#endif
+        default: scanScalar<S>(tracks, ids, 0, n, head, best); break;
+    }
+    if (best.slot == SIZE_MAX || (S == Side::Up && tracks[best.slot] < head) ||
+        (S == Side::Down && tracks[best.slot] > head)) {
+        return n;
+    }
+    return best.slot;
+}
+
+} // namespace nearest
+
+#endif // NEAREST_H
@@ -0,0 +1,85 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <algorithm>
+
+// Run task(0) .. task(count - 1) on up to one thread per core.
+//
+// Work stealing: each worker starts with a contiguous block of indices and
+// takes tasks from the front of it. A worker whose block runs dry steals the
+// back half of another worker's remaining block, so a few long simulations
+// do not leave the other cores idle.
+inline void parallelFor(size_t count, const std::function<void(size_t)>& task) {
+    size_t workers = std::min<size_t>(count, std::max(1u, std::thread::hardware_concurrency()));
+    if (workers <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            task(i);
+        }
+        return;
+    }
+
+    struct Block {
+        std::mutex lock;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+    std::vector<Block> blocks(workers);
+    for (size_t w = 0; w < workers; w++) {
+        blocks[w].begin = count * w / workers;
+        blocks[w].end = count * (w + 1) / workers;
+    }
+
+    auto worker = [&](size_t self) {
+        Block& own = blocks[self];
+        while (true) {
+            size_t index = count;
+            {
+                std::lock_guard<std::mutex> guard(own.lock);
+                if (own.begin < own.end) {
+                    index = own.begin++;
+                }
+            }
+            if (index < count) {
+                task(index);
+                continue;
+            }
+
+            // Own block is empty: steal from the next worker that has work left
+            bool stole = false;
+            for (size_t v = 1; v < workers && !stole; v++) {
+                Block& victim = blocks[(self + v) % workers];
+                size_t begin, end;
+                {
+                    std::lock_guard<std::mutex> guard(victim.lock);
+                    if (victim.begin >= victim.end) {
+                        continue;
+                    }
+                    begin = victim.begin + (victim.end - victim.begin) / 2;
+                    end = victim.end;
+                    victim.end = begin;
+                }
+                std::lock_guard<std::mutex> guard(own.lock);
+                own.begin = begin;
+                own.end = end;
+                stole = true;
+            }
+            if (!stole) {
+                return;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < workers; w++) {
+        threads.emplace_back(worker, w);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+#endif // PARALLEL_H
@@ -0,0 +1,167 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Hot-path profiling counters, compiled in only with -DIOSCHED_PROFILE
+// (make PROFILE=1). Each phase of the event loop is timed with the
+// timestamp counter, and the schedulers' selection routines count the
+// comparisons they make and the queue entries or tree nodes they visit.
+// Counters are per thread and are credited to a simulation when its run
+// ends, so compare mode can run simulations in parallel. In a normal build
+// every macro below expands to nothing.
+namespace profile {
+
+enum Phase { Admission, Completion, Dispatch, Select, HeadMovement, PhaseCount };
+
+inline const char* phaseName(int phase) {
+    switch (phase) {
+        case Admission: return "admission";
+        case Completion: return "completion";
+        case Dispatch: return "dispatch";
+        case Select: return "select";
+        default: return "head_movement";
+    }
+}
+
+// Timestamp counter on x86, steady_clock nanoseconds elsewhere
+inline uint64_t ticks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+inline const char* tickUnit() {
+#if defined(__x86_64__) || defined(__i386__)
+    return "cycles";
+#else
+    return "ns";
+#endif
+}
+
+struct Counters {
+    uint64_t calls[PhaseCount] = {};
+    uint64_t ticks[PhaseCount] = {};
+    uint64_t comparisons = 0; // Made by the selection routines
+    uint64_t nodes = 0;       // Queue entries or tree nodes they visited
+    uint64_t runTicks = 0;    // Whole runs, phases included
+    bool selecting = false;   // Inside a selection routine
+
+    void add(const Counters& other, int sign) {
+        for (int p = 0; p < PhaseCount; p++) {
+            calls[p] += sign * other.calls[p];
+            ticks[p] += sign * other.ticks[p];
+        }
+        comparisons += sign * other.comparisons;
+        nodes += sign * other.nodes;
+        runTicks += sign * other.runTicks;
+    }
+};
+
+inline Counters& local() {
+    thread_local Counters counters;
+    return counters;
+}
+
+// Times the enclosing scope as one call of a phase. Inside a Select phase
+// PROFILE_VISIT counts too.
+class PhaseTimer {
+private:
+    Phase phase;
+    bool wasSelecting;
+    uint64_t start;
+
+public:
+    explicit PhaseTimer(Phase p) : phase(p), wasSelecting(local().selecting), start(ticks()) {
+        if (phase == Select) local().selecting = true;
+    }
+
+    ~PhaseTimer() {
+        Counters& counters = local();
+        counters.calls[phase]++;
+        counters.ticks[phase] += profile::ticks() - start;
+        counters.selecting = wasSelecting;
+    }
+};
+
+// Credits what the thread counted during a run to that run's counters
+class RunTimer {
+private:
+    Counters& target;
+    Counters before;
+    uint64_t start;
+
+public:
+    explicit RunTimer(Counters& runCounters) : target(runCounters), before(local()), start(ticks()) {}
+
+    ~RunTimer() {
+        target.add(local(), 1);
+        target.add(before, -1);
+        target.runTicks += profile::ticks() - start;
+    }
+};
+
+// One row per phase: calls, total ticks, ticks per call and share of the
+// run, then the selection counts
+inline void printReport(std::ostream& out, const std::string& label, const Counters& c) {
+    out << "PROFILE " << label << " " << std::left << std::setw(14) << "phase" << std::right << std::setw(12) << "calls"
+        << std::setw(16) << tickUnit() << std::setw(10) << "per_call" << std::setw(8) << "share" << "\n";
+    for (int p = 0; p < PhaseCount; p++) {
+        double perCall = c.calls[p] ? static_cast<double>(c.ticks[p]) / c.calls[p] : 0;
+        double share = c.runTicks ? 100.0 * c.ticks[p] / c.runTicks : 0;
+        out << "PROFILE " << label << " " << std::left << std::setw(14) << phaseName(p) << std::right << std::setw(12)
+            << c.calls[p] << std::setw(16) << c.ticks[p] << std::setw(10) << std::fixed << std::setprecision(1) << perCall
+            << std::setw(7) << share << "%\n";
+    }
+    double selections = c.calls[Select] ? static_cast<double>(c.calls[Select]) : 1;
+    out << "PROFILE " << label << " run " << c.runTicks << " " << tickUnit() << ", select comparisons=" << c.comparisons
+        << " (" << std::setprecision(2) << c.comparisons / selections << " per call) nodes=" << c.nodes << " ("
+        << c.nodes / selections << " per call)\n";
+}
+
+// The same times in the folded stack format ("frame;frame value") read by
+// flamegraph.pl, speedscope and the other tools used with perf script
+// output. Select runs inside dispatch, so dispatch is reported without it.
+inline void printFolded(std::ostream& out, const std::string& label, const Counters& c) {
+    uint64_t phases = 0;
+    for (int p = 0; p < PhaseCount; p++) {
+        if (p != Select) phases += c.ticks[p];
+    }
+    std::string run = "iosched;" + label + ";run";
+    out << run << " " << (c.runTicks > phases ? c.runTicks - phases : 0) << "\n";
+    for (int p = 0; p < PhaseCount; p++) {
+        if (p == Select) continue;
+        uint64_t self = p == Dispatch && c.ticks[Dispatch] > c.ticks[Select] ? c.ticks[Dispatch] - c.ticks[Select] : c.ticks[p];
+        out << run << ";" << phaseName(p) << " " << self << "\n";
+    }
+    out << run << ";dispatch;select " << c.ticks[Select] << "\n";
+}
+
+} // namespace profile
+
+#ifdef IOSCHED_PROFILE
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_PHASE(phase) ::profile::PhaseTimer PROFILE_CONCAT(profilePhase_, __LINE__)(::profile::phase)
+#define PROFILE_RUN(counters) ::profile::RunTimer PROFILE_CONCAT(profileRun_, __LINE__)(counters)
+// Comparisons made and entries visited by a selection; only counted inside
+// a Select phase, so inserts and other lookups leave the counts alone
+#define PROFILE_VISIT(c, n) \
+    (::profile::local().selecting ? (void)(::profile::local().comparisons += (c), ::profile::local().nodes += (n)) : (void)0)
+#else
+#define PROFILE_PHASE(phase) ((void)0)
+#define PROFILE_RUN(counters) ((void)0)
+#define PROFILE_VISIT(c, n) ((void)0)
+#endif
+
+#endif // PROFILE_H
@@ -0,0 +1,167 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+// Binary snapshot of a simulation, for checkpoint and resume. Values are
+// appended raw in host byte order and read back in the same order, so a
+// snapshot is meant for the build that wrote it. Writing is a few memcpys
+// into one buffer and a single write to disk.
+//
+// A struct with padding would carry whatever bytes its padding happens to
+// hold, so the same state could give different snapshots. Such structs
+// list their members in a fields() method returning std::tie(...), and are
+// written member by member; any other type with padding is rejected.
+template <typename T>
+concept SnapshotFields = requires(T& value) { value.fields(); };
+
+template <typename T>
+constexpr bool snapshotRaw = std::is_trivially_copyable_v<T> &&
+                             (std::has_unique_object_representations_v<T> || std::is_floating_point_v<T>);
+
+// Bytes a value takes in a snapshot
+template <typename T>
+constexpr size_t snapshotSize();
+
+template <typename Fields, size_t... I>
+constexpr size_t snapshotFieldsSize(std::index_sequence<I...>) {
+    return (snapshotSize<std::remove_cvref_t<std::tuple_element_t<I, Fields>>>() + ... + 0);
+}
+
+template <typename T>
+constexpr size_t snapshotSize() {
+    if constexpr (SnapshotFields<T>) {
+        using Fields = decltype(std::declval<T&>().fields());
+        return snapshotFieldsSize<Fields>(std::make_index_sequence<std::tuple_size_v<Fields>>());
+    } else {
+        return sizeof(T);
+    }
+}
+
+class SnapshotWriter {
+private:
+    std::string data;
+
+public:
+    template <typename T>
+    void put(const T& value) {
+        if constexpr (SnapshotFields<T>) {
+            std::apply([this](const auto&... field) { (put(field), ...); }, const_cast<T&>(value).fields());
+        } else {
+            static_assert(snapshotRaw<T>, "snapshots hold plain values without padding; list the members in fields()");
+            data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+    }
+
+    template <typename T>
+    void putVector(const std::vector<T>& values) {
+        put<uint64_t>(values.size());
+        if constexpr (SnapshotFields<T>) {
+            for (const T& value : values) put(value);
+        } else {
+            static_assert(snapshotRaw<T>, "snapshots hold plain values without padding; list the members in fields()");
+            data.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+        }
+    }
+
+    const std::string& bytes() const { return data; }
+};
+
+// Reads a snapshot back. A truncated or corrupt snapshot does not read past
+// the end: every read after the first failure returns zeros and ok() turns
+// false.
+class SnapshotReader {
+private:
+    const char* pos;
+    const char* end;
+    bool valid = true;
+
+public:
+    explicit SnapshotReader(const std::string& bytes) : pos(bytes.data()), end(bytes.data() + bytes.size()) {}
+
+    template <typename T>
+    T get() {
+        T value{};
+        if constexpr (SnapshotFields<T>) {
+            std::apply([this](auto&... field) { (get(field), ...); }, value.fields());
+        } else {
+            static_assert(snapshotRaw<T>, "snapshots hold plain values without padding; list the members in fields()");
+            if (!valid || static_cast<size_t>(end - pos) < sizeof(T)) {
+                valid = false;
+                return value;
+            }
+            std::memcpy(&value, pos, sizeof(T));
+            pos += sizeof(T);
+        }
+        return value;
+    }
+
+    template <typename T>
+    void get(T& value) {
+        value = get<T>();
+    }
+
+    // Element count of a sequence that follows, 0 if the rest of the
+    // snapshot is too short to hold that many elements of the given size
+    size_t getCount(size_t elementSize) {
+        uint64_t count = get<uint64_t>();
+        if (elementSize > 0 && count > static_cast<uint64_t>(end - pos) / elementSize) {
+            valid = false;
+            return 0;
+        }
+        return count;
+    }
+
+    template <typename T>
+    void getVector(std::vector<T>& values) {
+        values.resize(getCount(snapshotSize<T>()));
+        if constexpr (SnapshotFields<T>) {
+            for (T& value : values) get(value);
+        } else if (!values.empty()) {
+            std::memcpy(values.data(), pos, values.size() * sizeof(T));
+            pos += values.size() * sizeof(T);
+        }
+    }
+
+    void fail() { valid = false; }
+    bool ok() const { return valid; }
+    bool atEnd() const { return pos == end; }
+};
+
+constexpr char snapshotMagic[8] = {'I', 'O', 'S', 'C', 'H', 'C', 'K', 'P'};
+
+// Write the snapshot next to the file and rename it over it, so an
+// interruption during the write leaves the previous snapshot intact
+inline bool writeSnapshot(const std::string& filename, const SnapshotWriter& snapshot) {
+    std::string temp = filename + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        file.write(snapshotMagic, sizeof(snapshotMagic));
+        file.write(snapshot.bytes().data(), snapshot.bytes().size());
+        if (!file) {
+            return false;
+        }
+    }
+    return std::rename(temp.c_str(), filename.c_str()) == 0;
+}
+
+inline bool readSnapshot(const std::string& filename, std::string& bytes) {
+    std::ifstream file(filename, std::ios::binary);
+    char magic[sizeof(snapshotMagic)];
+    if (!file.read(magic, sizeof(magic)) || std::memcmp(magic, snapshotMagic, sizeof(magic)) != 0) {
+        return false;
+    }
+    bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,200 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <cstdlib>
+
+#include "iosched.h"
+#include "trace.h"
+#include "parallel.h"
+#include "array.h"
+#include "cost.h"
+
+// Parameter grid for a sweep; every combination of the listed values is
+// one simulation run
+struct SweepSpec {
+    std::vector<std::string> traces;
+    std::string algorithms;
+    std::vector<int> devices;            // Array sizes; 1 when not given
+    std::vector<std::string> placements; // Placement policies; stripe when not given
+    std::vector<std::string> costs;      // Cost model presets; "default" is one unit per track
+    std::vector<CostModel> costModels;   // The presets above, loaded
+};
+
+// Outcome of one run in a sweep
+struct SweepResult {
+    std::string trace;
+    char algorithm;
+    int devices;
+    std::string placement;
+    std::string cost;
+    Statistics stats;
+};
+
+// Read a grid spec. Each line is "key = value value ...", with values
+// separated by blanks or commas; '#' starts a comment line:
+//
+//   trace     = tests/input0 tests/input1
+//   algo      = all
+//   devices   = 1 2 4 8
+//   placement = stripe:64 hash
+//   cost      = default presets/hdd7200.cost
+inline bool readSweepSpec(const std::string& filename, SweepSpec& spec) {
+    std::ifstream file(filename);
+    if (!file) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return false;
+    }
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#') continue; // Skip empty lines and comments
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            std::cerr << filename << ":" << lineNumber << ": expected key = values\n";
+            return false;
+        }
+        std::string key;
+        std::istringstream(line.substr(0, eq)) >> key;
+        std::string values = line.substr(eq + 1);
+        std::replace(values.begin(), values.end(), ',', ' ');
+        std::istringstream iss(values);
+        std::string value;
+
+        if (key == "trace") {
+            while (iss >> value) spec.traces.push_back(value);
+        } else if (key == "algo") {
+            while (iss >> value) spec.algorithms += value == "all" ? "NSLCFD" : value.substr(0, 1);
+        } else if (key == "devices") {
+            while (iss >> value) {
+                int count = std::atoi(value.c_str());
+                if (count < 1) {
+                    std::cerr << filename << ":" << lineNumber << ": invalid device count '" << value << "'\n";
+                    return false;
+                }
+                spec.devices.push_back(count);
+            }
+        } else if (key == "placement") {
+            while (iss >> value) {
+                PlacementPolicy policy;
+                if (!parsePlacementPolicy(value, policy)) {
+                    return false;
+                }
+                spec.placements.push_back(value);
+            }
+        } else if (key == "cost") {
+            while (iss >> value) {
+                CostModel model;
+                if (value != "default" && !loadCostModel(value, model)) {
+                    return false;
+                }
+                spec.costs.push_back(value);
+                spec.costModels.push_back(model);
+            }
+        } else {
+            std::cerr << filename << ":" << lineNumber << ": unknown key '" << key << "'\n";
+            return false;
+        }
+    }
+
+    if (spec.traces.empty() || spec.algorithms.empty()) {
+        std::cerr << filename << ": a sweep needs at least one trace and one algo\n";
+        return false;
+    }
+    for (char algorithm : spec.algorithms) {
+        if (!Simulator::create(algorithm)) {
+            std::cerr << "Invalid scheduler type specified: " << algorithm << "\n";
+            return false;
+        }
+    }
+    if (spec.devices.empty()) spec.devices.push_back(1);
+    if (spec.placements.empty()) spec.placements.push_back("stripe");
+    if (spec.costs.empty()) {
+        spec.costs.push_back("default");
+        spec.costModels.push_back(CostModel());
+    }
+    return true;
+}
+
+// Run every combination in the grid. Each trace is parsed once and shared
+// read-only by all runs that replay it.
+inline bool runSweep(const SweepSpec& spec, std::vector<SweepResult>& results) {
+    std::vector<std::vector<IORequest>> traces;
+    for (const auto& name : spec.traces) {
+        auto trace = openTrace(name);
+        if (!trace) {
+            return false;
+        }
+        traces.emplace_back();
+        IORequest req;
+        while (trace->next(req)) {
+            traces.back().push_back(req);
+        }
+    }
+
+    // Runs are numbered trace-major, then algorithm, devices, placement and cost
+    size_t algorithms = spec.algorithms.size();
+    size_t deviceCounts = spec.devices.size();
+    size_t placements = spec.placements.size();
+    size_t costs = spec.costs.size();
+    results.assign(traces.size() * algorithms * deviceCounts * placements * costs, SweepResult{});
+    parallelFor(results.size(), [&](size_t i) {
+        size_t c = i % costs;
+        size_t p = i / costs % placements;
+        size_t d = i / costs / placements % deviceCounts;
+        size_t a = i / costs / placements / deviceCounts % algorithms;
+        size_t t = i / costs / placements / deviceCounts / algorithms;
+        PlacementPolicy policy;
+        parsePlacementPolicy(spec.placements[p], policy);
+
+        auto array = DiskArray::create(spec.algorithms[a], spec.devices[d], policy, spec.costModels[c]);
+        VectorTraceSource replay(traces[t]);
+        array->run(replay);
+        results[i] = {spec.traces[t], spec.algorithms[a], spec.devices[d], spec.placements[p], spec.costs[c],
+                      array->statistics()};
+    });
+    return true;
+}
+
+inline void writeSweepCsv(std::ostream& out, const std::vector<SweepResult>& results) {
+    out << "trace,algo,devices,placement,cost,total_time,total_movement,io_utilization,avg_turnaround,avg_waittime,max_waittime\n";
+    for (const auto& r : results) {
+        out << r.trace << "," << r.algorithm << "," << r.devices << "," << r.placement << "," << r.cost << "," << r.stats.total_time << "," << r.stats.total_movement << ","
+            << std::fixed << std::setprecision(4) << r.stats.io_utilization << ","
+            << std::setprecision(2) << r.stats.avg_turnaround << "," << r.stats.avg_waittime << ","
+            << r.stats.max_waittime << "\n";
+    }
+}
+
+inline std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+// One JSON object per line
+inline void writeSweepJson(std::ostream& out, const std::vector<SweepResult>& results) {
+    for (const auto& r : results) {
+        out << "{\"trace\":\"" << jsonEscape(r.trace) << "\",\"algo\":\"" << r.algorithm << "\""
+            << ",\"devices\":" << r.devices << ",\"placement\":\"" << r.placement << "\""
+            << ",\"cost\":\"" << jsonEscape(r.cost) << "\""
+            << ",\"total_time\":" << r.stats.total_time << ",\"total_movement\":" << r.stats.total_movement
+            << std::fixed << std::setprecision(4) << ",\"io_utilization\":" << r.stats.io_utilization
+            << std::setprecision(2) << ",\"avg_turnaround\":" << r.stats.avg_turnaround
+            << ",\"avg_waittime\":" << r.stats.avg_waittime << ",\"max_waittime\":" << r.stats.max_waittime << "}\n";
+    }
+}
+
+#endif // SWEEP_H
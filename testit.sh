@@ -0,0 +1,65 @@
+#!/bin/bash
+
+# Runs the simulator on the reference inputs with every algorithm, and on
+# the extra cases below, and compares each output with the one in tests/.
+# usage: ./testit.sh [program]
+
+PROG=${1:-./iosched}
+DIR=tests
+
+[[ ! -x ${PROG} ]] && echo "program <$PROG> is not executable" && exit 1
+
+declare -i count=0
+declare -i failed=0
+
+# check <expected output> <command...>
+check()
+{
+    local expected=$1
+    shift
+    let count=${count}+1
+    if ! diff -b -q <("$@" 2>&1) ${DIR}/${expected} > /dev/null; then
+        echo "FAIL ${expected}: $*"
+        let failed=${failed}+1
+    fi
+}
+
+# maxwait <limit> <command...>: the max_waittime on the SUM line is at most limit
+maxwait()
+{
+    local limit=$1
+    shift
+    let count=${count}+1
+    local max=`"$@" | awk '/^SUM:/ { print $7 }'`
+    if [[ -z "${max}" || ${max} -gt ${limit} ]]; then
+        echo "FAIL max_waittime ${max} > ${limit}: $*"
+        let failed=${failed}+1
+    fi
+}
+
+for f in `seq 0 9`; do
+    for s in N S L C F; do
+        check out_${f}_${s} ${PROG} -s${s} ${DIR}/input${f}
+    done
+done
+
+# A stream of requests keeps the sweep going up while one request waits
+# behind the head. LOOK serves it when the stream ends; DEADLINE serves it
+# once the deadline has passed, within one seek of it.
+check out_10_L ${PROG} -sL -M ${DIR}/flat.cost ${DIR}/input10
+check out_10_D ${PROG} -sD -d 500:1 -M ${DIR}/flat.cost ${DIR}/input10
+maxwait 600 ${PROG} -sD -d 500:1 -M ${DIR}/flat.cost ${DIR}/input10
+maxwait 1700 ${PROG} -sD -M ${DIR}/flat.cost ${DIR}/input10
+
+# tests/input11 is input0 without its final newline. Read from stdin, the
+# last line comes through the stream reader's end-of-file path.
+check out_0_N bash -c "${PROG} -sN - < ${DIR}/input11"
+check out_0_N ${PROG} -sN ${DIR}/input11
+
+# Negative tracks on an array: placement rounds down, so each request lands
+# on a real device
+check out_12_L_stripe ${PROG} -sL -D 2 -P stripe:4 ${DIR}/input12
+check out_12_L_range ${PROG} -sL -D 3 -P range:32 ${DIR}/input12
+
+echo "${count} cases, ${failed} failed"
+[[ ${failed} == 0 ]]
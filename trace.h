@@ -0,0 +1,402 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <memory>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <cctype>
+#include <cstdint>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "iosched.h"
+
+// Parse "<arrivalTime> <track>" from one line. Follows the rules the
+// istream-based reader applied: leading whitespace is skipped, anything
+// after the second number is ignored, and a line that does not start with
+// two integers is dropped.
+inline bool parseTraceLine(const char* p, const char* end, int64_t& arrivalTime, int& track) {
+    auto parseInt = [&p, end](auto& value) {
+        while (p < end && std::isspace(static_cast<unsigned char>(*p))) p++;
+        if (p < end && *p == '+') p++;
+        auto [ptr, ec] = std::from_chars(p, end, value);
+        if (ec != std::errc()) return false;
+        p = ptr;
+        return true;
+    };
+    return parseInt(arrivalTime) && parseInt(track);
+}
+
+// Read-only private mapping of a whole file
+class MappedFile {
+private:
+    const char* data = nullptr;
+    size_t length = 0;
+    bool opened = false;
+
+public:
+    explicit MappedFile(const std::string& filename) {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0) {
+            length = st.st_size;
+            opened = true;
+            if (length > 0) {
+                void* map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (map == MAP_FAILED) {
+                    opened = false;
+                    length = 0;
+                } else {
+                    data = static_cast<const char*>(map);
+                }
+            }
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data) {
+            munmap(const_cast<char*>(data), length);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return opened; }
+    const char* begin() const { return data; }
+    size_t size() const { return length; }
+
+    void advise(size_t offset, size_t len, int advice) const {
+        if (data && len > 0) {
+            madvise(const_cast<char*>(data) + offset, len, advice);
+        }
+    }
+};
+
+// Streams requests out of a text trace through a read-only mapping. Pages
+// that have been parsed are handed back to the kernel as the reader moves
+// on, so resident memory stays bounded no matter how large the trace is.
+class TextTraceReader : public TraceSource {
+private:
+    static constexpr size_t releaseChunk = 64 << 20; // Bytes parsed between page releases
+
+    MappedFile file;
+    size_t pos = 0;
+    size_t released = 0; // Bytes already given back to the kernel
+    int requestId = 0;   // Start an ID counter for each request
+
+public:
+    explicit TextTraceReader(const std::string& filename) : file(filename) {
+        file.advise(0, file.size(), MADV_SEQUENTIAL);
+    }
+
+    bool isOpen() const { return file.isOpen(); }
+
+    bool next(IORequest& req) override {
+        const char* data = file.begin();
+        size_t size = file.size();
+        while (pos < size) {
+            const char* line = data + pos;
+            const char* eol = static_cast<const char*>(std::memchr(line, '\n', size - pos));
+            if (!eol) eol = data + size;
+            pos = eol - data + (eol < data + size ? 1 : 0);
+            releaseConsumed();
+
+            if (line == eol || line[0] == '#') continue; // Skip empty lines and comments
+            if (parseTraceLine(line, eol, req.arrivalTime, req.track)) {
+                req.id = requestId++; // Assign an incrementing ID to each request
+                req.startTime = 0;    // This will be set when the request is processed
+                req.endTime = 0;      // This will be set when the request completes
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    void releaseConsumed() {
+        if (pos - released < releaseChunk) {
+            return;
+        }
+        size_t pageSize = sysconf(_SC_PAGESIZE);
+        size_t upTo = pos / pageSize * pageSize;
+        file.advise(released, upTo - released, MADV_DONTNEED);
+        released = upTo;
+    }
+};
+
+// Reads a text trace from a pipe or stdin as the data arrives. Lines are
+// parsed with the same rules as TextTraceReader; next() blocks until the
+// writer sends the next complete line or closes its end.
+class StreamTraceReader : public TraceSource {
+private:
+    static constexpr size_t chunk = 64 << 10;
+
+    int fd;
+    bool ownsFd;
+    std::vector<char> buffer = std::vector<char>(chunk);
+    size_t begin = 0; // Unparsed bytes are [begin, end)
+    size_t end = 0;
+    bool eof = false;
+    int requestId = 0;
+
+    // Move the unparsed tail to the front and read more after it
+    bool fill() {
+        if (eof) {
+            return false;
+        }
+        std::memmove(buffer.data(), buffer.data() + begin, end - begin);
+        end -= begin;
+        begin = 0;
+        if (end == buffer.size()) {
+            buffer.resize(buffer.size() * 2); // A line longer than the buffer
+        }
+        ssize_t n;
+        do {
+            n = read(fd, buffer.data() + end, buffer.size() - end);
+        } while (n < 0 && errno == EINTR);
+        if (n <= 0) {
+            eof = true;
+            return false;
+        }
+        end += n;
+        return true;
+    }
+
+public:
+    // Read from an open descriptor; "-" in openTrace() maps to stdin
+    explicit StreamTraceReader(int descriptor, bool owns = false) : fd(descriptor), ownsFd(owns) {}
+
+    ~StreamTraceReader() {
+        if (ownsFd && fd >= 0) {
+            close(fd);
+        }
+    }
+
+    StreamTraceReader(const StreamTraceReader&) = delete;
+    StreamTraceReader& operator=(const StreamTraceReader&) = delete;
+
+    bool isOpen() const { return fd >= 0; }
+
+    bool next(IORequest& req) override {
+        while (true) {
+            const char* eol = static_cast<const char*>(std::memchr(buffer.data() + begin, '\n', end - begin));
+            if (!eol) {
+                if (fill()) continue;
+                if (begin == end) return false;
+                eol = buffer.data() + end; // Last line without a newline
+            }
+            const char* line = buffer.data() + begin; // Only now: fill() moves the buffer
+            begin = eol - buffer.data() + (eol < buffer.data() + end ? 1 : 0);
+
+            if (line == eol || line[0] == '#') continue; // Skip empty lines and comments
+            if (parseTraceLine(line, eol, req.arrivalTime, req.track)) {
+                req.id = requestId++;
+                req.startTime = 0;
+                req.endTime = 0;
+                return true;
+            }
+        }
+    }
+};
+
+// Binary trace format, version 1: a fixed header followed by `count`
+// fixed-width records in arrival order, all in host (little-endian) byte
+// order. Records are read straight out of the mapping without decoding.
+struct BinaryTraceHeader {
+    char magic[8];        // "IOSCHTRC"
+    uint32_t version;     // Format version, currently 1
+    uint32_t recordSize;  // sizeof(BinaryTraceRecord)
+    uint64_t count;       // Number of records that follow
+    int32_t maxTrack;     // Highest track referenced by any record
+    int32_t reserved;
+};
+
+struct BinaryTraceRecord {
+    int32_t arrivalTime;
+    int32_t track;
+};
+
+constexpr char binaryTraceMagic[8] = {'I', 'O', 'S', 'C', 'H', 'T', 'R', 'C'};
+constexpr uint32_t binaryTraceVersion = 1;
+static_assert(sizeof(BinaryTraceHeader) == 32, "binary trace header must stay 32 bytes");
+static_assert(sizeof(BinaryTraceRecord) == 8, "binary trace records must stay 8 bytes");
+
+// Zero-copy reader for the binary trace format
+class BinaryTraceReader : public TraceSource {
+private:
+    MappedFile file;
+    const BinaryTraceHeader* header = nullptr;
+    const BinaryTraceRecord* records = nullptr;
+    uint64_t pos = 0;
+
+public:
+    explicit BinaryTraceReader(const std::string& filename) : file(filename) {
+        if (!file.isOpen() || file.size() < sizeof(BinaryTraceHeader)) {
+            return;
+        }
+        auto hdr = reinterpret_cast<const BinaryTraceHeader*>(file.begin());
+        if (std::memcmp(hdr->magic, binaryTraceMagic, sizeof(binaryTraceMagic)) != 0 ||
+            hdr->version != binaryTraceVersion || hdr->recordSize != sizeof(BinaryTraceRecord) ||
+            hdr->count > (file.size() - sizeof(BinaryTraceHeader)) / sizeof(BinaryTraceRecord)) {
+            return;
+        }
+        header = hdr;
+        records = reinterpret_cast<const BinaryTraceRecord*>(file.begin() + sizeof(BinaryTraceHeader));
+        file.advise(0, file.size(), MADV_SEQUENTIAL);
+    }
+
+    bool isOpen() const { return header != nullptr; }
+    uint64_t count() const { return header ? header->count : 0; }
+    int maxTrack() const { return header ? header->maxTrack : 0; }
+
+    bool next(IORequest& req) override {
+        if (pos >= count()) {
+            return false;
+        }
+        const BinaryTraceRecord& rec = records[pos];
+        req.id = static_cast<int>(pos++);
+        req.arrivalTime = rec.arrivalTime;
+        req.track = rec.track;
+        req.startTime = 0;
+        req.endTime = 0;
+        return true;
+    }
+
+    long long skip(long long n) override {
+        uint64_t skipped = std::min<uint64_t>(n, count() - pos);
+        pos += skipped;
+        return skipped;
+    }
+};
+
+// Check whether a file starts with the binary trace magic
+inline bool isBinaryTrace(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    char magic[sizeof(binaryTraceMagic)];
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, binaryTraceMagic, sizeof(magic)) == 0;
+}
+
+// Open a text or binary trace, telling the two apart by the magic. "-"
+// reads a text trace from stdin, and so does a named pipe, which can only
+// be read once and front to back.
+inline std::unique_ptr<TraceSource> openTrace(const std::string& filename) {
+    if (filename == "-") {
+        return std::make_unique<StreamTraceReader>(STDIN_FILENO);
+    }
+    struct stat st;
+    if (stat(filename.c_str(), &st) == 0 && !S_ISREG(st.st_mode)) {
+        auto trace = std::make_unique<StreamTraceReader>(open(filename.c_str(), O_RDONLY), true);
+        if (!trace->isOpen()) {
+            std::cerr << "Error opening file: " << filename << std::endl;
+            return nullptr;
+        }
+        return trace;
+    }
+    if (isBinaryTrace(filename)) {
+        auto trace = std::make_unique<BinaryTraceReader>(filename);
+        if (!trace->isOpen()) {
+            std::cerr << "Invalid binary trace: " << filename << std::endl;
+            return nullptr;
+        }
+        return trace;
+    }
+    auto trace = std::make_unique<TextTraceReader>(filename);
+    if (!trace->isOpen()) {
+        std::cerr << "Error opening file: " << filename << std::endl;
+        return nullptr;
+    }
+    return trace;
+}
+
+// Write every request from a trace source as a binary trace; returns the
+// number of records written, or -1 if the output could not be written or
+// an arrival time does not fit the format's 32 bits
+inline long long writeBinaryTrace(TraceSource& trace, const std::string& filename) {
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        return -1;
+    }
+
+    BinaryTraceHeader header{};
+    std::memcpy(header.magic, binaryTraceMagic, sizeof(binaryTraceMagic));
+    header.version = binaryTraceVersion;
+    header.recordSize = sizeof(BinaryTraceRecord);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header)); // Rewritten once the count is known
+
+    std::vector<BinaryTraceRecord> buffer;
+    buffer.reserve(1 << 16);
+    IORequest req;
+    while (trace.next(req)) {
+        if (req.arrivalTime > INT32_MAX) {
+            std::cerr << "Arrival time too large for a binary trace: " << req.arrivalTime << std::endl;
+            return -1;
+        }
+        buffer.push_back({static_cast<int32_t>(req.arrivalTime), req.track});
+        header.maxTrack = std::max(header.maxTrack, req.track);
+        header.count++;
+        if (buffer.size() == buffer.capacity()) {
+            out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(BinaryTraceRecord));
+            buffer.clear();
+        }
+    }
+    out.write(reinterpret_cast<const char*>(buffer.data()), buffer.size() * sizeof(BinaryTraceRecord));
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    return out ? static_cast<long long>(header.count) : -1;
+}
+
+// Function to read all IO requests from file into memory
+inline std::vector<IORequest> readRequests(const std::string& filename) {
+    std::vector<IORequest> requests;
+    auto trace = openTrace(filename);
+    if (!trace) {
+        return requests;
+    }
+
+    IORequest req;
+    while (trace->next(req)) {
+        requests.push_back(req);
+    }
+    return requests;
+}
+
+// Replays a trace that is already in memory; the vector is only read, so
+// several sources can share one parsed trace across threads
+class VectorTraceSource : public TraceSource {
+private:
+    const std::vector<IORequest>& requests;
+    size_t pos = 0;
+
+public:
+    explicit VectorTraceSource(const std::vector<IORequest>& reqs) : requests(reqs) {}
+
+    bool next(IORequest& req) override {
+        if (pos >= requests.size()) {
+            return false;
+        }
+        req = requests[pos++];
+        return true;
+    }
+
+    long long skip(long long count) override {
+        size_t skipped = std::min<size_t>(count, requests.size() - pos);
+        pos += skipped;
+        return skipped;
+    }
+};
+
+#endif // TRACE_H